@@ -1,25 +1,33 @@
 #include "Barcode.h"
 
-#include <omp.h>
+#include <algorithm>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <vector>
+#include "Environment.h"
 #include "Individual.h"
+#include "RuleCircuit.h"
+#include "StepKernels.h"
+#include "TransitionCache.h"
 
 namespace ABME
 {
     using namespace cv;
 
+    static_assert(GlobalSettings::BarcodeSize == Barcode::Size, "Packed barcodes are 16x16.");
 
-    Barcode::Barcode(GeneSet& behaviourGenes, int width, int height) : behaviourGenes(behaviourGenes), width(width), height(height)
+    const BarcodeBits Barcode::InnerCellsMask = { InnerColumnsMask & ~0xFFFFULL, InnerColumnsMask, InnerColumnsMask, InnerColumnsMask & ~(0xFFFFULL << 48) };
+
+
+    Barcode::Barcode(const GeneBits& behaviourGenes, const RuleTable& rules) : behaviourGenes(behaviourGenes), rules(rules)
     {
-        // Create a string to represent the barcode with the proper length.
-        barcode = std::string(width * height, 0);
+
     }
 
 
-    Barcode::Barcode(const Barcode& rhs) : behaviourGenes(rhs.behaviourGenes), barcode(rhs.barcode), width(rhs.width), height(rhs.height)
+    Barcode::Barcode(const Barcode& rhs) : behaviourGenes(rhs.behaviourGenes), rules(rhs.rules), barcode(rhs.barcode), history(rhs.history), countedBarcode(rhs.countedBarcode)
     {
+        std::copy(std::begin(rhs.laneCounts), std::end(rhs.laneCounts), std::begin(laneCounts));
         
     }
 
@@ -28,96 +36,105 @@ namespace ABME
     /// barcode pixels are alternating in the directions (+i, +j, -i, -j).
     /// Also computes current number of active cells.
     /// Only considers the inner 14 x 14 cells (not the boundary cells). 
-    void Barcode::ComputeMetrics(Vec2i& movement, int& cellsActive) const
+    void Barcode::ComputeMetrics(Vec2i& movement, int& cellsActive)
     {
-        float positiveX = 0.f;
-        float positiveY = 0.f;
-
-        for (auto i = width + 1; i < barcode.size() - (width + 1); ++i)
+        // Reuse the metrics if the barcode was reached by a recorded step that has them.
+        auto* record = history.GetLatest(barcode);
+        if (record != nullptr && record->HasMetrics)
         {
-            // Ignore barcode elements on the left/right boundaries.
-            auto x = i % width;
-            if (x == 0 || x == 15) continue;
+            movement = record->Movement;
+            cellsActive += record->CellsActive;
+            return;
+        }
+
+        // Direction lanes: cell i contributes to lane i % 4, i.e. every fourth column.
+        // The lane counts are updated by the cells that changed since they were last counted.
+        const std::uint64_t laneMasks[4] = { 0x1111111111111111ULL, 0x2222222222222222ULL, 0x4444444444444444ULL, 0x8888888888888888ULL };
 
+        for (auto w = 0; w < 4; ++w)
+        {
             // Note: boundary cells are influenced by border effects.
-            if (barcode[i] != 0)
-            {
-                // Increment consumption.
-                cellsActive += 1;
+            auto changed = (barcode[w] ^ countedBarcode[w]) & InnerCellsMask[w];
+            if (changed == 0) continue;
 
-                // Normalise movement increments so that updates are fair 
-                // with respect to cells available. 
-                switch (i % 4)
-                {
-                case 0:
-                    positiveX += 1.0f;
-                    break;
-                case 1:
-                    positiveY += 0.75f;
-                    break;
-                case 2:
-                    positiveX -= 0.75f;
-                    break;
-                case 3:
-                    positiveY -= 1.0f;
-                    break;
-                }
+            for (auto lane = 0; lane < 4; ++lane)
+            {
+                laneCounts[lane] += Helpers::PopCount(barcode[w] & changed & laneMasks[lane]) - Helpers::PopCount(countedBarcode[w] & changed & laneMasks[lane]);
             }
         }
 
+        countedBarcode = barcode;
+
+        // Increment consumption.
+        cellsActive += laneCounts[0] + laneCounts[1] + laneCounts[2] + laneCounts[3];
+
+        // Normalise movement increments so that updates are fair 
+        // with respect to cells available. 
+        float positiveX = 1.0f * laneCounts[0] - 0.75f * laneCounts[2];
+        float positiveY = 0.75f * laneCounts[1] - 1.0f * laneCounts[3];
+
         // Update motion.
         movement[0] = int(positiveX);
         movement[1] = int(positiveY);
+
+        if (record != nullptr)
+        {
+            record->Movement = movement;
+            record->CellsActive = laneCounts[0] + laneCounts[1] + laneCounts[2] + laneCounts[3];
+            record->HasMetrics = true;
+        }
     }
 
 
     int Barcode::CountLiveCells() const
     {
-        auto count = 0;
-        for (uchar c : barcode)
-        {
-            if (c == 1) ++count;
-        }
-
-        return count;
+        return Helpers::PopCount(barcode);
     }
 
 
     /// Debug draw the current barcode.
     void Barcode::Draw(std::string& windowName) const
     {
-        Mat image(height * CellSize, width * CellSize, CV_8UC1);
+        Mat image(Size * CellSize, Size * CellSize, CV_8UC1);
 
-        for (auto i = 0; i < height; ++i)
+        for (auto i = 0; i < Size; ++i)
         {
-            for (auto j = 0; j < width; ++j)
+            for (auto j = 0; j < Size; ++j)
             {
-                uchar c = barcode[i * width + j];
-                rectangle(image, Point(j * CellSize, i * CellSize), Point(j * CellSize + CellSize, i * CellSize + CellSize), (c == 1 ? 0 : 200), cv::FILLED);
+                bool c = Helpers::TestBit(barcode, i * Size + j);
+                rectangle(image, Point(j * CellSize, i * CellSize), Point(j * CellSize + CellSize, i * CellSize + CellSize), (c ? 0 : 200), cv::FILLED);
             }
         }
 
         imshow(windowName, image);
     }
 
-    const std::string& Barcode::GetStringRepresentation() const
+    const BarcodeBits& Barcode::GetBits() const
     {
         return barcode;
     }
 
 
-    /// Integrates environmental input into the barcode, additively.
-    void Barcode::Input(cv::Mat& environment)
+    /// Returns a one-byte-per-cell copy of the barcode (for debugging only).
+    std::string Barcode::GetStringRepresentation() const
     {
-        for (int j = 0; j < environment.rows; j++) 
+        std::string representation(Size * Size, 0);
+        for (auto i = 0; i < Size * Size; ++i)
         {
-            for (int i = 0; i < environment.cols; i++)
-            {
-                if (environment.at<uchar>(j, i) > 0) 
-                {
-                    barcode[j * width + i] = 1;
-                }
-            }
+            representation[i] = Helpers::TestBit(barcode, i) ? 1 : 0;
+        }
+
+        return representation;
+    }
+
+
+    /// Integrates environmental input (the tiles under the barcode, anchored
+    /// at (x, y)) into the barcode, additively.
+    void Barcode::Input(const PackedMap& environment, int x, int y)
+    {
+        for (int j = 0; j < Size; j++) 
+        {
+            barcode[j >> 2] |= std::uint64_t(environment.GetRow(x, y + j)) << ((j & 3) * Size);
         }
     }
 
@@ -126,27 +143,22 @@ namespace ABME
     /// those that were set in both this and rhs.
     void Barcode::Intersect(const Barcode& rhs)
     {
-        auto rhsBarcode = rhs.barcode;
-        for (auto i = 0; i < rhsBarcode.size(); ++i)
+        for (auto w = 0; w < 4; ++w)
         {
-            if (rhsBarcode[i] == 0)
-            {
-                barcode[i] = 0;
-            }
+            barcode[w] &= rhs.barcode[w];
         }
     }
 
 
     /// Randomly adds food tiles to the environment.
     /// Note: numToTake must be negative here.
-    void Barcode::DropTiles(cv::Mat& environment, int x, int y, int& numToTake, std::vector<Rect>& regions, std::vector<int>& balances, bool useActiveCells) const
+    void Barcode::DropTiles(Environment& environment, int x, int y, int& numToTake, bool useActiveCells) const
     {
         std::vector<int> relativeIndices;
         for (auto i = 0; i < GlobalSettings::BarcodeSize * GlobalSettings::BarcodeSize; ++i)
         {
-            auto& tile = environment.at<uchar>(y + i / GlobalSettings::BarcodeSize, x + i % GlobalSettings::BarcodeSize);
-            auto& cell = barcode[i];
-            if (tile == 0 && (!useActiveCells || cell == 1)) relativeIndices.push_back(i);
+            const auto active = environment.GetMap().Get(x + i % GlobalSettings::BarcodeSize, y + i / GlobalSettings::BarcodeSize);
+            if (!active && (!useActiveCells || Helpers::TestBit(barcode, i))) relativeIndices.push_back(i);
         }
 
         // Shuffle the indices.
@@ -158,25 +170,21 @@ namespace ABME
             auto tileX = x + i % GlobalSettings::BarcodeSize;
             auto tileY = y + i / GlobalSettings::BarcodeSize;
 
-            // Update region balance.
-            auto index = Helpers::PointInRegionIndex(Point(tileX, tileY), regions);
-            --balances[index];
-
             // Activate tile.
-            environment.at<uchar>(tileY, tileX) = 255;
+            environment.WriteTile(tileX, tileY, true, TileSourceIndividuals);
             ++numToTake;
             if (numToTake >= 0) break;
         }
     }
 
 
-    void Barcode::ExtractTiles(cv::Mat& environment, int x, int y, int& numToTake, std::vector<Rect>& regions, std::vector<int>& balances) const
+    void Barcode::ExtractTiles(Environment& environment, int x, int y, int& numToTake) const
     {
         std::vector<int> relativeIndices;
         for (auto i = 0; i < GlobalSettings::BarcodeSize * GlobalSettings::BarcodeSize; ++i)
         {
-            auto& tile = environment.at<uchar>(y + i / GlobalSettings::BarcodeSize, x + i % GlobalSettings::BarcodeSize);
-            if (tile == 255) relativeIndices.push_back(i);
+            const auto active = environment.GetMap().Get(x + i % GlobalSettings::BarcodeSize, y + i / GlobalSettings::BarcodeSize);
+            if (active) relativeIndices.push_back(i);
         }
 
         // Shuffle the indices.
@@ -188,22 +196,66 @@ namespace ABME
             auto tileX = x + i % GlobalSettings::BarcodeSize;
             auto tileY = y + i / GlobalSettings::BarcodeSize;
 
-            // Update region balance.
-            auto index = Helpers::PointInRegionIndex(Point(tileX, tileY), regions);
-            ++balances[index];
-
             // Deactivate tile.
-            environment.at<uchar>(tileY, tileX) = 0;
+            environment.WriteTile(tileX, tileY, false, TileSourceIndividuals);
             --numToTake;
             if (numToTake <= 0) break;
         }
     }
 
 
-    /// Replaces the string representation of the current barcode.
+    /// Steps the barcode from its history if it is periodic and its current
+    /// state (after input) was stepped from before. Returns whether it did.
+    bool Barcode::Repeat()
+    {
+        if (!history.IsPeriodic()) return false;
+
+        auto* found = history.Find(barcode);
+        if (found == nullptr) return false;
+
+        // The record may be overwritten by the push.
+        const auto recorded = *found;
+        auto& record = history.Push(barcode, recorded.Next);
+        record.Movement = recorded.Movement;
+        record.CellsActive = recorded.CellsActive;
+        record.HasMetrics = recorded.HasMetrics;
+
+        barcode = recorded.Next;
+        return true;
+    }
+
+
+    /// Replaces the current barcode.
+    void Barcode::SetBits(const BarcodeBits& bits)
+    {
+        barcode = bits;
+    }
+
+
+    /// Replaces the current barcode from a one-byte-per-cell representation (for debugging only).
     void Barcode::SetStringRepresentation(const std::string& rep)
     {
-        barcode = rep;
+        for (auto i = 0; i < Size * Size; ++i)
+        {
+            Helpers::AssignBit(barcode, i, rep[i] != 0);
+        }
+    }
+
+
+    /// Returns the next step of a barcode under compiled behaviour genes, with
+    /// every cell evaluated and nothing recorded. Allocates nothing, so it can
+    /// run in tight loops over barcodes that have no history.
+    BarcodeBits Barcode::Step(const BarcodeBits& state, const RuleTable& rules, bool useLongPatterns)
+    {
+        auto next = state;
+        const auto useCache = GlobalSettings::UseTransitionCache && !(rules.Circuit != nullptr && rules.Circuit->IsCompact());
+        if (useCache && TransitionCache::Instance().Find(rules.Fingerprint, rules.Checksum, state, next)) return next;
+
+        const BarcodeBits all = { ~0ULL, ~0ULL, ~0ULL, ~0ULL };
+        ApplyRules(state, rules, useLongPatterns, all, 0xFFFF, next);
+
+        if (useCache) TransitionCache::Instance().Insert(rules.Fingerprint, rules.Checksum, state, next);
+        return next;
     }
 
 
@@ -211,26 +263,24 @@ namespace ABME
     /// the rhs.
     void Barcode::Subtract(const Barcode& rhs)
     {
-        auto rhsBarcode = rhs.barcode;
-        for (auto i = 0; i < rhsBarcode.size(); ++i)
+        for (auto w = 0; w < 4; ++w)
         {
-            if (rhsBarcode[i] == 1)
-            {
-                barcode[i] = 0;
-            }
+            barcode[w] &= ~rhs.barcode[w];
         }
     }
 
     
     /// Updates the barcode pattern by one step.
-    /// Note: only allows up to 3x3 patterns.
+    /// With usePatternMap, genes up to 3x3 are read from the compiled rule tables
+    /// (5x5 genes from the sparse table); otherwise each gene is matched explicitly.
+    /// Note: only allows up to 3x3 patterns without the pattern map.
     void Barcode::Update(bool usePatternMap, bool useLongPatterns)
     {
-        auto oldBarcode = barcode;
+        const auto oldBarcode = barcode;
 
         if (!usePatternMap)
         {
-            for (auto&[key, val] : behaviourGenes)
+            for (const auto [key, val] : behaviourGenes)
             {
                 std::string pattern = Helpers::GetParentPattern(key);
                 if (pattern.size() <= 3) Update1D(pattern, val, oldBarcode);
@@ -239,44 +289,72 @@ namespace ABME
         }
         else
         {
-            // Do the 1D genes first.
-            for (auto&[key, val] : behaviourGenes)
+            // A barcode in a cycle repeats its recorded step.
+            if (Repeat()) return;
+
+            // Compact circuits are cheaper to evaluate than to look up.
+            const auto useCache = GlobalSettings::UseTransitionCache && !(rules.Circuit != nullptr && rules.Circuit->IsCompact());
+            if (useCache && TransitionCache::Instance().Find(rules.Fingerprint, rules.Checksum, oldBarcode, barcode))
             {
-                if (key >= 10) break;
-                std::string pattern = Helpers::GetParentPattern(key);
-                Update1D(pattern, val, oldBarcode);
+                history.Push(oldBarcode, barcode);
+                return;
+            }
+
+            // Only cells whose neighbourhood changed since the last step need evaluating;
+            // the others step as they did then.
+            const auto* last = history.GetLatest();
+            BarcodeBits dirty = { ~0ULL, ~0ULL, ~0ULL, ~0ULL };
+            auto dirtyRows = 0xFFFF;
+            if (last != nullptr)
+            {
+                for (auto w = 0; w < 4; ++w) dirty[w] = oldBarcode[w] ^ last->State[w];
+                dirty = Dilate(dirty);
+                if (useLongPatterns) dirty = Dilate(dirty);
+
+                dirtyRows = 0;
+                for (auto j = 0; j < Size; ++j)
+                {
+                    if (Helpers::GetRow(dirty, j) != 0) dirtyRows |= 1 << j;
+                }
             }
 
-            // Do the 3x3 2D genes next.
-            Update2DWithPatternMap(oldBarcode, 3);
+            if (dirtyRows != 0) ApplyRules(oldBarcode, rules, useLongPatterns, dirty, dirtyRows, barcode);
 
-            // Do the 5x5 2D genes next...
-            if (useLongPatterns) Update2DWithPatternMap(oldBarcode, 5);
+            if (last != nullptr)
+            {
+                for (auto w = 0; w < 4; ++w) barcode[w] = (barcode[w] & dirty[w]) | (last->Next[w] & ~dirty[w]);
+            }
+
+            if (useCache) TransitionCache::Instance().Insert(rules.Fingerprint, rules.Checksum, oldBarcode, barcode);
         }
+
+        history.Push(oldBarcode, barcode);
     }
 
 
     /// Updates the world map with a small probability.
     /// Only finishes the action if it finds enough tiles to replace the ones added.
     /// Returns whether the update was successful.
-    bool Barcode::UpdateWorld(cv::Mat& environment, int x, int y, double probability)
+    bool Barcode::UpdateWorld(Environment& environment, int x, int y, double probability)
     {
+        const auto& map = environment.GetMap();
         std::uniform_real_distribution<> dist(0.0, 1.0);
         std::vector<Point> pointsToAdd;
         std::vector<int> removablePoints;
 
         auto count = 0;
-        for (auto i = 0; i < barcode.size(); ++i)
+        for (auto i = 0; i < Size * Size; ++i)
         {
-            int tileX = x + i % width;
-            int tileY = y + i / width;
-            if (barcode[i] == 1 && environment.at<uchar>(tileY, tileX) == 0 && dist(GlobalSettings::RNG) < probability)
+            int tileX = x + i % Size;
+            int tileY = y + i / Size;
+            bool cell = Helpers::TestBit(barcode, i);
+            if (cell && !map.Get(tileX, tileY) && dist(GlobalSettings::RNG) < probability)
             {
                 pointsToAdd.push_back(Point(tileX, tileY));
                 ++count;
             }
 
-            if (barcode[i] == 0 && environment.at<uchar>(tileY, tileX) == 255) removablePoints.push_back(i);
+            if (!cell && map.Get(tileX, tileY)) removablePoints.push_back(i);
         }
         
         // We have failed to update if there are fewer tiles to remove.
@@ -285,7 +363,7 @@ namespace ABME
         // Otherwise just fill the spots immediately.
         for (auto& p : pointsToAdd)
         {
-            environment.at<uchar>(p.y, p.x) = 255;
+            environment.WriteTile(p.x, p.y, true, TileSourceIndividuals);
         }
 
         // Shuffle the removable points.
@@ -298,7 +376,7 @@ namespace ABME
             auto tileX = x + i % GlobalSettings::BarcodeSize;
             auto tileY = y + i / GlobalSettings::BarcodeSize;
 
-            environment.at<uchar>(tileY, tileX) = 0;
+            environment.WriteTile(tileX, tileY, false, TileSourceIndividuals);
             --count;
         }
 
@@ -306,111 +384,156 @@ namespace ABME
     }
 
 
-    void Barcode::Update1D(std::string& pattern, uchar& replacement, std::string& oldBarcode, std::string* updateInto)
+    /// Writes the replacement value into every matched cell.
+    void Barcode::Apply(const BarcodeBits& matches, uchar replacement)
     {
-        std::string& update = updateInto == nullptr ? barcode : *updateInto;
-
-#pragma omp parallel for
-        for (int j = 0; j < height; ++j)
+        for (auto w = 0; w < 4; ++w)
         {
-            std::string subBarcode = oldBarcode.substr(j * width, width);
-            std::vector<size_t> positions;
-            positions.reserve(GlobalSettings::BarcodeSize);
+            barcode[w] = replacement == 1 ? barcode[w] | matches[w] : barcode[w] & ~matches[w];
+        }
+    }
 
-            size_t pos = subBarcode.find(pattern, 0);
-            while (pos != std::string::npos)
+
+    /// Writes the cells of the dirty rows that match a compiled gene into
+    /// barcode: the 1D genes, then the 3x3 genes (with the synthesised circuit
+    /// if it is small, which already includes the 1D genes for the inner
+    /// cells), then the 5x5 genes.
+    void Barcode::ApplyRules(const BarcodeBits& oldBarcode, const RuleTable& rules, bool useLongPatterns, const BarcodeBits& dirty, int dirtyRows, BarcodeBits& barcode)
+    {
+        Update1DWithRuleTable(oldBarcode, rules, barcode);
+
+        if (rules.Circuit != nullptr && rules.Circuit->IsCompact())
+        {
+            auto inner = rules.Circuit->Evaluate(oldBarcode);
+            for (auto w = 0; w < 4; ++w)
             {
-                positions.push_back(pos);
-                pos = subBarcode.find(pattern, pos + 1);
+                barcode[w] = (barcode[w] & ~InnerCellsMask[w]) | (inner[w] & InnerCellsMask[w]);
             }
+        }
+        else
+        {
+            StepKernels::Step3x3(oldBarcode, rules, barcode, dirtyRows);
+        }
 
-            // Replace in the new pattern.
+        if (useLongPatterns) Update5x5WithRuleTable(oldBarcode, rules, dirty, barcode);
+    }
+
+
+    /// Matches a 1- or 3-cell horizontal pattern against every position
+    /// of every row (3-cell patterns replace the central cell).
+    void Barcode::Update1D(const std::string& pattern, uchar replacement, const BarcodeBits& oldBarcode)
+    {
+        BarcodeBits matches;
+        for (auto w = 0; w < 4; ++w)
+        {
+            const auto cells = oldBarcode[w];
             if (pattern.size() == 1)
             {
-                for (auto& pos : positions)
-                {
-                    update[width * j + pos] = replacement;
-                }
+                matches[w] = pattern[0] == 1 ? cells : ~cells;
             }
-            else if (pattern.size() == 3)
+            else
             {
-                for (auto& pos : positions)
-                {
-                    update[width * j + pos + 1] = replacement;
-                }
+                // Bits that cross row boundaries land in the excluded edge columns.
+                const auto left = cells << 1;
+                const auto right = cells >> 1;
+                matches[w] = (pattern[0] == 1 ? left : ~left) & (pattern[1] == 1 ? cells : ~cells) & (pattern[2] == 1 ? right : ~right) & InnerColumnsMask;
             }
         }
+
+        Apply(matches, replacement);
     }
 
 
-    void Barcode::Update2D(std::string& pattern, uchar& replacement, std::string& oldBarcode, std::string* updateInto)
+    /// Matches a 3x3 pattern against every inner cell, replacing the central cell.
+    void Barcode::Update2D(const std::string& pattern, uchar replacement, const BarcodeBits& oldBarcode)
     {
-        std::string& update = updateInto == nullptr ? barcode : *updateInto;
-
-#pragma omp parallel for
-        for (int j = 0; j < height - 2; ++j)
+        auto matches = InnerCellsMask;
+        for (auto k = 0; k < 9; ++k)
         {
-            auto subBarcode = oldBarcode.substr(j * width, width);
-            std::vector<size_t> firstMatchPositions;
-            std::vector<size_t> positions;
-
-            auto firstPatternLine = pattern.substr(0, 3);
-
-            size_t pos = subBarcode.find(firstPatternLine, 0);
-            while (pos != std::string::npos)
+            auto neighbours = Shift(oldBarcode, (k / 3 - 1) * Size + (k % 3 - 1));
+            for (auto w = 0; w < 4; ++w)
             {
-                firstMatchPositions.push_back(pos);
-                pos = subBarcode.find(firstPatternLine, pos + 1);
+                matches[w] &= pattern[k] == 1 ? neighbours[w] : ~neighbours[w];
             }
+        }
+
+        Apply(matches, replacement);
+    }
+
+
+    /// Applies the compiled 1- and 3-cell genes to every row. Each cell matches
+    /// exactly one entry per table, so the 3-cell genes override the 1-cell ones.
+    void Barcode::Update1DWithRuleTable(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode)
+    {
+        for (auto w = 0; w < 4; ++w)
+        {
+            const auto cells = oldBarcode[w];
+            auto updated = barcode[w];
 
-            // Check that the other lines match too.
-            for (auto& pos : firstMatchPositions)
+            for (auto code = 0; code < 2; ++code)
             {
-                auto secondLine = oldBarcode.substr((j + 1) * width + pos, 3);
-                auto thirdLine = oldBarcode.substr((j + 2) * width + pos, 3);
+                const auto value = rules.Rules1[code];
+                if (value == RuleTable::NoGene) continue;
 
-                if (secondLine == pattern.substr(3, 3) && thirdLine == pattern.substr(6, 3))
-                {
-                    positions.push_back(pos);
-                }
+                const auto matches = code == 1 ? cells : ~cells;
+                updated = value == 1 ? updated | matches : updated & ~matches;
             }
 
-            // Replace in the new pattern.
-            for (auto& pos : positions)
+            // Bits that cross row boundaries land in the excluded edge columns.
+            const auto left = cells << 1;
+            const auto right = cells >> 1;
+            for (auto code = 0; code < 8; ++code)
             {
-                update[width * (j + 1) + pos + 1] = replacement;
+                const auto value = rules.Rules3[code];
+                if (value == RuleTable::NoGene) continue;
+
+                const auto matches = ((code & 1) ? left : ~left) & ((code & 2) ? cells : ~cells) & ((code & 4) ? right : ~right) & InnerColumnsMask;
+                updated = value == 1 ? updated | matches : updated & ~matches;
             }
+
+            barcode[w] = updated;
         }
     }
 
 
-    void Barcode::Update2DWithPatternMap(std::string& oldBarcode, int patternWidth)
+    /// Applies the 5x5 genes to the dirty cells at least two cells from the edges.
+    /// Windows are packed column by column (as the table is indexed), so each
+    /// row's windows are packed incrementally from left to right: the window
+    /// is shifted a column left and the next column of the transposed barcode
+    /// is put in its last.
+    void Barcode::Update5x5WithRuleTable(const BarcodeBits& oldBarcode, const RuleTable& rules, const BarcodeBits& dirty, BarcodeBits& barcode)
     {
-        auto& map = patternWidth <= 3 ? Individual::ShortGenePatternMap : Individual::LongGenePatternMap;
-
-        const int edgeLimit = patternWidth - 1;
-        const int replaceOffset = (patternWidth - 1) / 2;
+        if (rules.Rules25.Size() == 0) return;
 
-#pragma omp parallel for
-        for (int j = 0; j < height - edgeLimit; ++j)
+        // Transpose the barcode by swapping ever smaller blocks: bit j of columns[i] is row j, column i.
+        std::uint32_t columns[Size];
+        for (auto j = 0; j < Size; ++j) columns[j] = Helpers::GetRow(oldBarcode, j);
+        for (std::uint32_t shift = Size / 2, mask = 0x00FF; shift != 0; shift >>= 1, mask ^= mask << shift)
         {
-            for (int i = 0; i < width - edgeLimit; ++i)
+            for (std::uint32_t k = 0; k < Size; k = ((k | shift) + 1) & ~shift)
             {
-                // Get the pattern at this position of the barcode.
-                std::string subBarcode;
-                for (auto k = j; k < j + patternWidth; ++k)
-                {
-                    subBarcode += oldBarcode.substr(k * width + i, patternWidth);
-                }
+                const auto swapped = ((columns[k] >> shift) ^ columns[k | shift]) & mask;
+                columns[k] ^= swapped << shift;
+                columns[k | shift] ^= swapped;
+            }
+        }
 
-                // Find which gene this would require.
-                auto& geneIndex = map[subBarcode];
+        for (int j = 2; j < Size - 2; ++j)
+        {
+            const auto dirtyColumns = Helpers::GetRow(dirty, j) & InnerRowMask5x5;
+            if (dirtyColumns == 0) continue;
+
+            // Start with the four columns left of the first window's last one.
+            auto code = 0;
+            for (auto i = 0; i < 4; ++i) code = (code >> 5) | ((columns[i] >> (j - 2)) & 31) << 20;
 
-                // Do we have this gene?
-                if (behaviourGenes.count(geneIndex) == 0) continue;
+            for (int i = 2; i < Size - 2; ++i)
+            {
+                code = (code >> 5) | ((columns[i + 2] >> (j - 2)) & 31) << 20;
+                if (((dirtyColumns >> i) & 1) == 0) continue;
 
-                // Replace at the right position.
-                barcode[width * (j + replaceOffset) + i + replaceOffset] = behaviourGenes[geneIndex];
+                const auto value = rules.Rules25.Find(code);
+                if (value != RuleTable::NoGene) Helpers::AssignBit(barcode, Size * j + i, value == 1);
             }
         }
     }
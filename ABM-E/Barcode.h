@@ -2,39 +2,112 @@
 
 #include <opencv2/highgui.hpp>
 #include <string.h>
+#include "BarcodeHistory.h"
+#include "GeneBits.h"
 #include "Helpers.h"
+#include "PackedMap.h"
+#include "RuleTable.h"
 
 namespace ABME
 {
+    class Environment;
+
+    /// A 16x16 binary barcode, packed as a bitboard of four 64-bit words
+    /// (four rows of 16 cells per word).
     class Barcode
     {
     public:
-        Barcode(GeneSet& chromosome, int width, int height);
+        Barcode(const GeneBits& behaviourGenes, const RuleTable& rules);
         Barcode(const Barcode& rhs);
 
-        void ComputeMetrics(cv::Vec2i& movement, int& cellsActive) const;
+        void ComputeMetrics(cv::Vec2i& movement, int& cellsActive);
         int CountLiveCells() const;
         void Draw(std::string& windowName) const;
-        void DropTiles(cv::Mat& environment, int x, int y, int& numFoodTiles, std::vector<cv::Rect>& regions, std::vector<int>& balances, bool useActiveCells) const;
-        void ExtractTiles(cv::Mat& environment, int x, int y, int& numFoodTiles, std::vector<cv::Rect>& regions, std::vector<int>& balances) const;
-        const std::string& GetStringRepresentation() const;
-        void Input(cv::Mat& environment);
+        void DropTiles(Environment& environment, int x, int y, int& numFoodTiles, bool useActiveCells) const;
+        void ExtractTiles(Environment& environment, int x, int y, int& numFoodTiles) const;
+        const BarcodeBits& GetBits() const;
+        std::string GetStringRepresentation() const;
+        void Input(const PackedMap& environment, int x, int y);
         void Intersect(const Barcode& rhs);
+        bool Repeat();
+        void SetBits(const BarcodeBits& bits);
         void SetStringRepresentation(const std::string& rep);
+        static BarcodeBits Step(const BarcodeBits& state, const RuleTable& rules, bool useLongPatterns);
         void Subtract(const Barcode& rhs);
         void Update(bool usePatternMap, bool useLongPatterns);
-        bool UpdateWorld(cv::Mat& environment, int x, int y, double probability);
+        bool UpdateWorld(Environment& environment, int x, int y, double probability);
+
+        inline int GetPeriod() const
+        {
+            return history.GetPeriod();
+        }
+
+
+        /// Returns the barcode shifted so that cell i of the result holds cell
+        /// (i + offset) of the input, filling with zeros. Requires |offset| < 64.
+        static inline BarcodeBits Shift(const BarcodeBits& bits, int offset)
+        {
+            if (offset == 0) return bits;
+
+            BarcodeBits shifted = {};
+            if (offset > 0)
+            {
+                for (auto w = 0; w < 4; ++w)
+                {
+                    shifted[w] = bits[w] >> offset;
+                    if (w < 3) shifted[w] |= bits[w + 1] << (64 - offset);
+                }
+            }
+            else
+            {
+                for (auto w = 0; w < 4; ++w)
+                {
+                    shifted[w] = bits[w] << -offset;
+                    if (w > 0) shifted[w] |= bits[w - 1] >> (64 + offset);
+                }
+            }
+
+            return shifted;
+        }
+
+
+        /// Returns the cells within one cell (including diagonally) of a set cell.
+        /// Cells spilling over row ends only add cells, so the result is a superset.
+        static inline BarcodeBits Dilate(const BarcodeBits& bits)
+        {
+            BarcodeBits dilated;
+            for (auto w = 0; w < 4; ++w) dilated[w] = bits[w] | bits[w] << 1 | bits[w] >> 1;
+
+            const auto above = Shift(dilated, -Size);
+            const auto below = Shift(dilated, Size);
+            for (auto w = 0; w < 4; ++w) dilated[w] |= above[w] | below[w];
+
+            return dilated;
+        }
+
+
+
+        static const int Size = 16;
+        static const std::uint64_t InnerColumnsMask = 0x7FFE7FFE7FFE7FFEULL; // Columns 1..14 of every row.
+        static const BarcodeBits InnerCellsMask; // Rows 1..14, columns 1..14.
 
     protected:
-        inline void Update1D(std::string& pattern, uchar& replacement, std::string& oldBarcode, std::string* updateInto = nullptr);
-        inline void Update2D(std::string& pattern, uchar& replacement, std::string& oldBarcode, std::string* updateInto = nullptr);
-        inline void Update2DWithPatternMap(std::string& oldBarcode, int patternWidth);
+        inline void Update1D(const std::string& pattern, uchar replacement, const BarcodeBits& oldBarcode);
+        inline void Update2D(const std::string& pattern, uchar replacement, const BarcodeBits& oldBarcode);
+        inline void Apply(const BarcodeBits& matches, uchar replacement);
+
+        static void ApplyRules(const BarcodeBits& oldBarcode, const RuleTable& rules, bool useLongPatterns, const BarcodeBits& dirty, int dirtyRows, BarcodeBits& barcode);
+        static inline void Update1DWithRuleTable(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode);
+        static inline void Update5x5WithRuleTable(const BarcodeBits& oldBarcode, const RuleTable& rules, const BarcodeBits& dirty, BarcodeBits& barcode);
 
-        GeneSet& behaviourGenes;
-        std::string barcode;
-        int width;
-        int height;
+        const GeneBits& behaviourGenes;
+        const RuleTable& rules;
+        BarcodeBits barcode = {};
+        BarcodeHistory history;
+        BarcodeBits countedBarcode = {}; // The barcode laneCounts were last counted for.
+        int laneCounts[4] = { 0, 0, 0, 0 };
 
         static const int CellSize = 16;
+        static const int InnerRowMask5x5 = 0x3FFC; // Columns 2..13, the centres of 5x5 windows.
     };
 }
\ No newline at end of file
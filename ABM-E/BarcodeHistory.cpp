@@ -0,0 +1,69 @@
+#include "BarcodeHistory.h"
+
+namespace ABME
+{
+    void BarcodeHistory::Clear()
+    {
+        Count = 0;
+        Latest = -1;
+        Period = 0;
+    }
+
+
+    /// Returns the most recent record stepping from the state, if any.
+    const BarcodeHistory::Record* BarcodeHistory::Find(const BarcodeBits& state) const
+    {
+        const auto hash = Helpers::Hash(state);
+        for (auto d = 0; d < Count; ++d)
+        {
+            auto& record = Records[(Latest - d + Depth) % Depth];
+            if (record.Hash == hash && record.State == state) return &record;
+        }
+
+        return nullptr;
+    }
+
+
+    const BarcodeHistory::Record* BarcodeHistory::GetLatest() const
+    {
+        return Latest < 0 ? nullptr : &Records[Latest];
+    }
+
+
+    /// Returns the latest record if it stepped to the given barcode, i.e. if the
+    /// barcode has not been changed since.
+    BarcodeHistory::Record* BarcodeHistory::GetLatest(const BarcodeBits& next)
+    {
+        if (Latest < 0 || Records[Latest].Next != next) return nullptr;
+        return &Records[Latest];
+    }
+
+
+    /// Appends a step, updating the period.
+    BarcodeHistory::Record& BarcodeHistory::Push(const BarcodeBits& state, const BarcodeBits& next)
+    {
+        const auto hash = Helpers::Hash(state);
+
+        Period = 0;
+        for (auto d = 0; d < Count; ++d)
+        {
+            auto& record = Records[(Latest - d + Depth) % Depth];
+            if (record.Hash == hash && record.State == state)
+            {
+                Period = d + 1;
+                break;
+            }
+        }
+
+        Latest = (Latest + 1) % Depth;
+        Count = std::min(Count + 1, Depth);
+
+        auto& record = Records[Latest];
+        record.Hash = hash;
+        record.State = state;
+        record.Next = next;
+        record.HasMetrics = false;
+
+        return record;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// The most recent steps of one barcode, used to detect fixed points and
+    /// short cycles. Each record is a transition from the barcode as it was
+    /// updated (after input) to the next barcode, and caches the metrics of the
+    /// next barcode once computed. A step repeating an earlier one Period steps
+    /// back marks the barcode as periodic.
+    class BarcodeHistory
+    {
+    public:
+        struct Record
+        {
+            std::uint64_t Hash = 0;
+            BarcodeBits State = {};
+            BarcodeBits Next = {};
+            cv::Vec2i Movement;
+            int CellsActive = 0;
+            bool HasMetrics = false;
+        };
+
+        void Clear();
+        const Record* Find(const BarcodeBits& state) const;
+        const Record* GetLatest() const;
+        Record* GetLatest(const BarcodeBits& next);
+        Record& Push(const BarcodeBits& state, const BarcodeBits& next);
+
+        /// Returns the distance to the last repetition of the latest step,
+        /// or 0 if it did not repeat within the history.
+        inline int GetPeriod() const
+        {
+            return Period;
+        }
+
+
+        inline bool IsPeriodic() const
+        {
+            return Period > 0;
+        }
+
+
+        static constexpr int Depth = 8; // The longest detectable period.
+
+    protected:
+        Record Records[Depth];
+        int Count = 0;
+        int Latest = -1;
+        int Period = 0;
+    };
+}
@@ -0,0 +1,117 @@
+#include "Benchmarks.h"
+
+#include <chrono>
+#include <iomanip>
+#include "Barcode.h"
+#include "GlobalSettings.h"
+#include "Helpers.h"
+#include "RuleTable.h"
+
+namespace ABME
+{
+    void Benchmarks::Run(std::ostream& out)
+    {
+        Run5x5Steps(out);
+    }
+
+
+    /// Times barcode steps of genomes with 0, 10, 100 and 1000 5x5 genes (on top
+    /// of 64 3x3 genes), stepping from random barcodes so that no step can be
+    /// replayed. Random windows almost never match a 5x5 gene, so a few of the
+    /// genome's own patterns are planted in each barcode, and the steps are
+    /// timed with both. For comparison, also times looking up the 5x5 windows
+    /// of a planted step in the gene set, as the pattern map engine did.
+    void Benchmarks::Run5x5Steps(std::ostream& out)
+    {
+        const int numStates = 1024;
+        const int numSteps = 20000;
+        const auto useTransitionCache = GlobalSettings::UseTransitionCache;
+        GlobalSettings::UseTransitionCache = false;
+
+        std::mt19937_64 rng(GlobalSettings::Seed);
+        std::vector<BarcodeBits> states(numStates);
+        for (auto& state : states)
+        {
+            for (auto& word : state) word = rng();
+        }
+
+        const int numPlanted = 4;
+
+        out << "5x5 genes | step, random (ns) | step, planted (ns) | gene set lookups (ns) | matches per step\n";
+        for (auto numLongGenes : { 0, 10, 100, 1000 })
+        {
+            std::uniform_int_distribution<int> dist3x3(Helpers::GetGeneOffset(9), Helpers::GetGeneOffset(25) - 1);
+            std::uniform_int_distribution<int> dist5x5(Helpers::GetGeneOffset(25), Helpers::GetGeneOffset(25) + (1 << 25) - 1);
+
+            GeneSet genes;
+            while (genes.size() < 64) genes[dist3x3(rng)] = rng() & 1;
+            while (genes.size() < 64 + numLongGenes) genes[dist5x5(rng)] = rng() & 1;
+
+            // Unless NumGenes includes the 5x5 genes, only the rule tables can hold them.
+            GeneBits shortGenes;
+            for (auto&[index, value] : genes)
+            {
+                if (index < GeneBits::Capacity) shortGenes.Set(index, value);
+            }
+
+            RuleTable rules;
+            rules.Compile(genes);
+            Barcode barcode(shortGenes, rules);
+
+            // Plant 5x5 patterns of the genome at random inner cells.
+            std::vector<int> codes;
+            for (auto&[index, value] : genes)
+            {
+                if (index >= Helpers::GetGeneOffset(25)) codes.push_back(Helpers::ReverseBits(index - Helpers::GetGeneOffset(25), 25));
+            }
+
+            auto planted = states;
+            for (auto& state : planted)
+            {
+                for (auto p = 0; p < numPlanted && !codes.empty(); ++p)
+                {
+                    const auto code = codes[rng() % codes.size()];
+                    const auto i = 2 + int(rng() % (Barcode::Size - 4));
+                    const auto j = 2 + int(rng() % (Barcode::Size - 4));
+                    for (auto k = 0; k < 25; ++k) Helpers::AssignBit(state, Barcode::Size * (j - 2 + k / 5) + i - 2 + k % 5, ((code >> k) & 1) != 0);
+                }
+            }
+
+            const auto timeSteps = [&](const std::vector<BarcodeBits>& from)
+            {
+                const auto begin = std::chrono::steady_clock::now();
+                for (auto s = 0; s < numSteps; ++s)
+                {
+                    barcode.SetBits(from[s % numStates]);
+                    barcode.Update(true, numLongGenes > 0);
+                }
+
+                return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / numSteps;
+            };
+
+            const auto randomTime = timeSteps(states);
+            const auto plantedTime = timeSteps(planted);
+
+            auto found = 0;
+            const auto begin = std::chrono::steady_clock::now();
+            for (auto s = 0; s < numSteps; ++s)
+            {
+                auto& state = planted[s % numStates];
+                for (auto j = 0; j < Barcode::Size - 4; ++j)
+                {
+                    for (auto i = 0; i < Barcode::Size - 4; ++i)
+                    {
+                        auto code = 0;
+                        for (auto k = 0; k < 5; ++k) code |= ((Helpers::GetRow(state, j + k) >> i) & 31) << (5 * k);
+                        found += genes.count(Helpers::GetGeneIndex(code, 25));
+                    }
+                }
+            }
+            const auto lookupTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / numSteps;
+
+            out << std::setw(9) << numLongGenes << " | " << std::setw(17) << std::fixed << std::setprecision(1) << randomTime << " | " << std::setw(18) << plantedTime << " | " << std::setw(21) << lookupTime << " | " << std::setw(16) << double(found) / numSteps << "\n";
+        }
+
+        GlobalSettings::UseTransitionCache = useTransitionCache;
+    }
+}
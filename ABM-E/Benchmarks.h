@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ostream>
+
+namespace ABME
+{
+    /// Microbenchmarks of the simulation's hot paths, run with --benchmark.
+    class Benchmarks
+    {
+    public:
+        static void Run(std::ostream& out);
+        static void Run5x5Steps(std::ostream& out);
+    };
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <limits>
+#include "GeneBits.h"
 #include "Helpers.h"
+#include "Message.h"
+#include "RuleCircuit.h"
+#include "RuleTable.h"
 
 namespace ABME
 {
@@ -90,11 +94,61 @@ namespace ABME
 
         inline size_t Length() const
         {
-            return Genes.size();
+            return size_t(Genes.Count());
         }
 
 
-        GeneSet Genes;
+        /// Reads the genes and rates written by Write. The rules are not
+        /// compiled.
+        inline void Read(MessageReader& message)
+        {
+            Genes = GeneBits();
+            const auto numGenes = message.Read<std::uint32_t>();
+            for (std::uint32_t i = 0; i < numGenes; ++i)
+            {
+                const auto index = message.Read<int>();
+                Genes.Set(index, message.Read<uchar>());
+            }
+
+            HasLargePatterns = message.Read<bool>();
+            MaxGeneValue = message.Read<uchar>();
+            FlipMutationRate = message.Read<TParam>();
+            InsertionMutationRate = message.Read<TParam>();
+            DeletionMutationRate = message.Read<TParam>();
+            TransMutationRate = message.Read<TParam>();
+        }
+
+
+        /// Writes the genes and rates (not the compiled rules) to a message.
+        inline void Write(MessageWriter& message) const
+        {
+            message.Write(std::uint32_t(Genes.Count()));
+            for (const auto [index, value] : Genes)
+            {
+                message.Write(index);
+                message.Write(value);
+            }
+
+            message.Write(HasLargePatterns);
+            message.Write(MaxGeneValue);
+            message.Write(FlipMutationRate);
+            message.Write(InsertionMutationRate);
+            message.Write(DeletionMutationRate);
+            message.Write(TransMutationRate);
+        }
+
+
+        /// Compiles the genes into lookup tables, and optionally a circuit.
+        /// Must be called whenever Genes changes.
+        inline void Compile(bool synthesiseCircuit = false)
+        {
+            Rules.Compile(Genes);
+            if (synthesiseCircuit) Rules.Circuit = RuleCircuit::Synthesise(Genes, Rules);
+        }
+
+
+        GeneBits Genes;
+        RuleTable Rules;
         bool HasLargePatterns = false;
         uchar MaxGeneValue;
 
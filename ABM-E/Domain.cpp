@@ -0,0 +1,269 @@
+#include "Domain.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include "GlobalSettings.h"
+#include "Logger.h"
+#include "Message.h"
+#include "PackedMap.h"
+
+namespace ABME
+{
+    Domain::Domain(int width, int height, Transport& transport) : ItsTransport(transport), Height(height)
+    {
+        const auto rows = (height + transport.GetSize() - 1) / transport.GetSize();
+
+        // The farthest an individual moves between handovers: its barcode moves
+        // it at most three quarters of the 4 x 14 inner cells of a direction
+        // lane, and random motion and births at most a distance step.
+        const auto travel = std::max(3 * (GlobalSettings::BarcodeSize - 2), GlobalSettings::DistanceStep);
+
+        // Individuals must only ever cross into the next strip. Every worker
+        // must agree, so the check covers the last strip, the shortest.
+        if (height - (transport.GetSize() - 1) * rows < travel) throw std::runtime_error("The world is too short to be split between this many workers.");
+
+        Top = transport.GetRank() * rows;
+        Bottom = std::min(height, Top + rows);
+        HaloBottom = std::min(height, Bottom + GlobalSettings::BarcodeSize - 1);
+
+        // The origin stays on the grid of distance steps, which every position is on.
+        Origin = std::max(0, Top - travel) / GlobalSettings::DistanceStep * GlobalSettings::DistanceStep;
+        End = std::min(height, Bottom + travel + GlobalSettings::BarcodeSize - 1);
+        ItsEnvironment.reset(new Environment(width, End - Origin, Origin));
+    }
+
+
+    /// Adds a region of the world. Its part in the strip is given its share of
+    /// the active tiles; its parts in the halo and margins start empty, and
+    /// are regions of their own so no tiles are generated there.
+    void Domain::AddRegion(cv::Rect region, float activeProbability)
+    {
+        const auto width = ItsEnvironment->GetMap().GetWidth();
+        const cv::Rect parts[] = { cv::Rect(0, Origin, width, Top - Origin), cv::Rect(0, Top, width, Bottom - Top), cv::Rect(0, Bottom, width, End - Bottom) };
+        for (auto i = 0; i < 3; ++i)
+        {
+            auto part = region & parts[i];
+            if (part.empty()) continue;
+
+            part.y -= Origin;
+            ItsEnvironment->AddRegion(part, i == 1 ? activeProbability : 0.0f);
+        }
+    }
+
+
+    /// Counts the active tiles of the strip.
+    int Domain::CountActiveTiles() const
+    {
+        const auto& map = ItsEnvironment->GetMap();
+        auto count = 0;
+        for (auto y = Top; y < Bottom; ++y)
+        {
+            for (auto x = 0; x < map.GetWidth(); x += PackedMap::RowLength) count += Helpers::PopCount(std::uint64_t(map.GetRow(x, y - Origin)));
+        }
+
+        return count;
+    }
+
+
+    int Domain::GetBottom() const
+    {
+        return Bottom;
+    }
+
+
+    Environment& Domain::GetEnvironment()
+    {
+        return *ItsEnvironment;
+    }
+
+
+    int Domain::GetTop() const
+    {
+        return Top;
+    }
+
+
+    /// Populates the strip, drawing from this worker's own random seed. The
+    /// individuals are placed over all the rows the environment holds, in
+    /// proportion to them, and only those anchored in the strip are kept, so
+    /// the world is as evenly populated as an undivided one.
+    void Domain::Initialise(std::map<int, int> lengthCounts, bool useSameGeneIndices, bool useSimpleGenesFirst)
+    {
+        GlobalSettings::Seed = int(Helpers::HashCombine(std::uint64_t(GlobalSettings::Seed), std::uint64_t(ItsTransport.GetRank())));
+        GlobalSettings::RNG.seed(GlobalSettings::Seed);
+
+        const auto anchors = Height - GlobalSettings::BarcodeSize + 1;
+        const auto heldAnchors = End - Origin - GlobalSettings::BarcodeSize + 1;
+        for (auto& [length, count] : lengthCounts) count = int(std::int64_t(count) * heldAnchors / anchors);
+
+        ItsEnvironment->Initialise(lengthCounts, useSameGeneIndices, useSimpleGenesFirst);
+
+        std::vector<uchar> up, down;
+        ItsEnvironment->Emigrate(Top, Bottom, up, down);
+    }
+
+
+    /// Gathers the number of individuals and active tiles of every strip on
+    /// the first worker, which logs them with their totals.
+    void Domain::LogTotals() const
+    {
+        MessageWriter counts;
+        counts.Write(ItsEnvironment->GetIndividuals().Size());
+        counts.Write(CountActiveTiles());
+
+        const auto rank = ItsTransport.GetRank();
+        if (rank > 0)
+        {
+            ItsTransport.Send(0, counts.Bytes);
+            return;
+        }
+
+        std::stringstream log;
+        auto numIndividuals = 0, numTiles = 0;
+        for (auto peer = 0; peer < ItsTransport.GetSize(); ++peer)
+        {
+            const auto message = peer == 0 ? counts.Bytes : ItsTransport.Receive(peer);
+            MessageReader reader(message);
+            const auto individuals = reader.Read<int>();
+            const auto tiles = reader.Read<int>();
+            log << "Worker " << peer << ": " << individuals << " individuals, " << tiles << " active tiles\n";
+
+            numIndividuals += individuals;
+            numTiles += tiles;
+        }
+
+        log << "Total: " << numIndividuals << " individuals, " << numTiles << " active tiles\n";
+        Logger::Instance() << log.str();
+    }
+
+
+    /// Steps the strip, keeping the halos and the individuals of neighbouring
+    /// strips consistent. Every worker must call it the same number of times.
+    void Domain::Update()
+    {
+        const auto rank = ItsTransport.GetRank();
+        const auto hasAbove = rank > 0;
+        const auto hasBelow = rank + 1 < ItsTransport.GetSize();
+        const auto width = ItsEnvironment->GetMap().GetWidth();
+        const auto aboveHaloBottom = Top + GlobalSettings::BarcodeSize - 1; // The halo of the worker above ends within the strip.
+
+        // Refresh the halo from the worker below, and refresh the one above's.
+        // Then swap the barcodes of the individuals anchored within a barcode
+        // of each edge, which the other side senses.
+        std::vector<uchar> neighbours;
+        if (hasAbove)
+        {
+            ItsTransport.Exchange(rank - 1, PackRows(Top, aboveHaloBottom));
+            neighbours = ItsTransport.Exchange(rank - 1, ItsEnvironment->ListBarcodes(Top, aboveHaloBottom));
+        }
+
+        if (hasBelow)
+        {
+            UnpackRows(Bottom, HaloBottom, ItsTransport.Exchange(rank + 1, {}));
+            const auto below = ItsTransport.Exchange(rank + 1, ItsEnvironment->ListBarcodes(Bottom - GlobalSettings::BarcodeSize + 1, Bottom));
+            neighbours.insert(neighbours.end(), below.begin(), below.end());
+        }
+
+        ItsEnvironment->SetNeighbours(neighbours);
+
+        const auto before = PackRows(Bottom, HaloBottom);
+        HaloBefore.assign(before.size() / sizeof(ushort), 0);
+        if (!before.empty()) std::memcpy(HaloBefore.data(), before.data(), before.size());
+
+        ItsEnvironment->Act();
+
+        // Send the halo tiles changed by this strip's individuals down, as
+        // each piece of a row followed by the mask of its changed tiles.
+        MessageWriter changes;
+        if (hasBelow)
+        {
+            auto piece = 0;
+            for (auto y = Bottom; y < HaloBottom; ++y)
+            {
+                for (auto x = 0; x < width; x += PackedMap::RowLength, ++piece)
+                {
+                    const auto bits = ushort(ItsEnvironment->GetMap().GetRow(x, y - Origin));
+                    changes.Write(bits);
+                    changes.Write(ushort(bits ^ HaloBefore[piece]));
+                }
+            }
+        }
+
+        std::vector<uchar> fromAbove;
+        if (hasAbove) fromAbove = ItsTransport.Exchange(rank - 1, {});
+        if (hasBelow) ItsTransport.Exchange(rank + 1, changes.Bytes);
+
+        MessageReader reader(fromAbove);
+        for (auto y = Top; y < aboveHaloBottom && !fromAbove.empty(); ++y)
+        {
+            for (auto x = 0; x < width; x += PackedMap::RowLength)
+            {
+                const auto bits = reader.Read<ushort>();
+                const auto changed = reader.Read<ushort>();
+                for (auto i = 0; i < PackedMap::RowLength && x + i < width; ++i)
+                {
+                    if ((changed >> i) & 1) ItsEnvironment->WriteTile(x + i, y - Origin, ((bits >> i) & 1) != 0, TileSourceNeighbours);
+                }
+            }
+        }
+
+        // Individuals that moved out of the strip interact where they landed,
+        // and random motion and births may take others out.
+        Migrate();
+        ItsEnvironment->Interact();
+        Migrate();
+    }
+
+
+    /// Hands the individuals anchored outside the strip to the worker above or
+    /// below, and takes in those they hand over.
+    void Domain::Migrate()
+    {
+        const auto rank = ItsTransport.GetRank();
+
+        std::vector<uchar> up, down;
+        ItsEnvironment->Emigrate(Top, Bottom, up, down);
+
+        std::vector<uchar> fromAbove, fromBelow;
+        if (rank > 0) fromAbove = ItsTransport.Exchange(rank - 1, up);
+        if (rank + 1 < ItsTransport.GetSize()) fromBelow = ItsTransport.Exchange(rank + 1, down);
+        ItsEnvironment->Immigrate(fromAbove);
+        ItsEnvironment->Immigrate(fromBelow);
+    }
+
+
+    /// Packs rows of the world, in pieces of PackedMap::RowLength tiles.
+    std::vector<uchar> Domain::PackRows(int top, int bottom) const
+    {
+        const auto& map = ItsEnvironment->GetMap();
+        MessageWriter rows;
+        for (auto y = top; y < bottom; ++y)
+        {
+            for (auto x = 0; x < map.GetWidth(); x += PackedMap::RowLength) rows.Write(ushort(map.GetRow(x, y - Origin)));
+        }
+
+        return std::move(rows.Bytes);
+    }
+
+
+    /// Replaces rows of the world with those packed by another worker.
+    void Domain::UnpackRows(int top, int bottom, const std::vector<uchar>& message)
+    {
+        const auto width = ItsEnvironment->GetMap().GetWidth();
+        MessageReader reader(message);
+        for (auto y = top; y < bottom; ++y)
+        {
+            for (auto x = 0; x < width; x += PackedMap::RowLength)
+            {
+                const auto bits = reader.Read<ushort>();
+                const auto current = ItsEnvironment->GetMap().GetRow(x, y - Origin);
+                for (auto i = 0; i < PackedMap::RowLength && x + i < width; ++i)
+                {
+                    if (((bits ^ current) >> i) & 1) ItsEnvironment->WriteTile(x + i, y - Origin, ((bits >> i) & 1) != 0, TileSourceNeighbours);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "Environment.h"
+#include "Transport.h"
+
+namespace ABME
+{
+    /// One worker's share of a world split into horizontal strips, one strip
+    /// per worker. A worker's environment holds only its strip, the halo of
+    /// rows below it that the strip's individuals sense and write, and margins
+    /// either side that individuals can move into before being handed over;
+    /// its rows are offset by the environment's origin.
+    ///
+    /// Each step, the halo is refreshed from the worker below, and the
+    /// barcodes of the individuals anchored near either edge are swapped with
+    /// the neighbours, so the individuals of each strip sense those of the
+    /// next. The individuals then act; the tiles they changed in the halo are
+    /// sent back, and those that moved out of the strip are handed to the
+    /// worker above or below before they interact, so individuals sharing a
+    /// position always meet, whichever strip they came from. Those moved out
+    /// by the interactions are handed over at the end of the step.
+    class Domain
+    {
+    public:
+        Domain(int width, int height, Transport& transport);
+
+        void AddRegion(cv::Rect region, float activeProbability);
+        int CountActiveTiles() const;
+        int GetBottom() const;
+        Environment& GetEnvironment();
+        int GetTop() const;
+        void Initialise(std::map<int, int> lengthCounts, bool useSameGeneIndices, bool useSimpleGenesFirst);
+        void LogTotals() const;
+        void Update();
+
+    protected:
+        void Migrate();
+        std::vector<uchar> PackRows(int top, int bottom) const;
+        void UnpackRows(int top, int bottom, const std::vector<uchar>& message);
+
+        Transport& ItsTransport;
+        int Height; // Of the world.
+        int Top; // First row of the strip.
+        int Bottom; // One past the last row of the strip.
+        int HaloBottom; // One past the last row of the halo.
+        int Origin; // First row of the environment.
+        int End; // One past the last row of the environment.
+        std::unique_ptr<Environment> ItsEnvironment;
+        std::vector<ushort> HaloBefore; // The halo as received, before the update.
+    };
+}
@@ -1,6 +1,7 @@
 #include "Environment.h"
 
 #include <algorithm>
+#include <omp.h>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <random>
@@ -8,26 +9,55 @@
 #include "GlobalSettings.h"
 #include "Helpers.h"
 #include "Individual.h"
+#include "InteractionCache.h"
 #include "Interactor.h"
 #include "Logger.h"
+#include "Message.h"
+#include "TransitionCache.h"
 
 namespace ABME
 {
     using namespace cv;
 
-    Environment::Environment(int width, int height) : Map(height, width, CV_8UC1)
+    /// Creates an environment of width x height tiles. An environment holding a
+    /// strip of a larger world (see Domain) passes the world row of its first
+    /// row as the origin; messages to and from other environments use world rows.
+    Environment::Environment(int width, int height, int origin) : Individuals(Pool), Captured(Pool), Origin(origin)
     {
-        Map = Scalar(0);
+        Map.Reset(width, height);
+
+        // The snapshot starts empty, with every block to be rebuilt.
+        Snapshot.Reset(width, height);
+        SnapshotBlocksPerRow = (width + GlobalSettings::BarcodeSize - 1) / GlobalSettings::BarcodeSize;
+        SnapshotBlockChanged.assign(SnapshotBlocksPerRow * ((height + GlobalSettings::BarcodeSize - 1) / GlobalSettings::BarcodeSize), 0);
+        SnapshotChangedBlocks.resize(omp_get_max_threads());
+        MarkChanged(Rect(0, 0, width, height));
+        ChangedTiles.resize(omp_get_max_threads());
+
+        RegionRaster.Reset(width, height);
 
         // Seed RNG.
         auto randomDevice = std::random_device();
     }
 
 
+    /// The first half of a step: every individual senses the world, steps its
+    /// barcode, processes the world under it and moves.
+    void Environment::Act()
+    {
+        // Bring the additive snapshot of the world + barcodes up to date.
+        UpdateSnapshot();
+
+        // Update all individuals, then file the tiles they wrote.
+        UpdateIndividuals();
+        ApplyChangedTiles();
+    }
+
+
     void Environment::AddPopulation(int numIndividuals, int geneticLength, bool useSameGeneIndices, bool useSimpleGenesFirst)
     {
-        std::uniform_int_distribution<std::mt19937::result_type> distWidth(0, Map.cols - GlobalSettings::BarcodeSize);
-        std::uniform_int_distribution<std::mt19937::result_type> distHeight(0, Map.rows - GlobalSettings::BarcodeSize);
+        std::uniform_int_distribution<std::mt19937::result_type> distWidth(0, Map.GetWidth() - GlobalSettings::BarcodeSize);
+        std::uniform_int_distribution<std::mt19937::result_type> distHeight(0, Map.GetHeight() - GlobalSettings::BarcodeSize);
 
         // Create individuals.
         auto prototypeBehaviour = Helpers::GenerateRandomChromosome(geneticLength, useSimpleGenesFirst, GlobalSettings::BehaviourGenePossibilities);
@@ -37,41 +67,44 @@ namespace ABME
         {
             GeneticCode<ushort> geneticCode;
 
-            geneticCode.BehaviourGenes.Genes = useSameGeneIndices ? 
+            geneticCode.BehaviourGenes.Genes = GeneBits(useSameGeneIndices ? 
                 Helpers::GenerateRandomChromosome(prototypeBehaviour, GlobalSettings::BehaviourGenePossibilities) : 
-                Helpers::GenerateRandomChromosome(geneticLength, useSimpleGenesFirst, GlobalSettings::BehaviourGenePossibilities);
-            geneticCode.InteractionGenes.Genes = useSameGeneIndices ? 
+                Helpers::GenerateRandomChromosome(geneticLength, useSimpleGenesFirst, GlobalSettings::BehaviourGenePossibilities));
+            geneticCode.InteractionGenes.Genes = GeneBits(useSameGeneIndices ? 
                 Helpers::GenerateRandomChromosome(prototypeInteraction, GlobalSettings::InteractionGenePossibilities) :
-                Helpers::GenerateRandomChromosome(geneticLength, useSimpleGenesFirst, GlobalSettings::InteractionGenePossibilities);
+                Helpers::GenerateRandomChromosome(geneticLength, useSimpleGenesFirst, GlobalSettings::InteractionGenePossibilities));
 
-            Individuals.push_back(std::make_unique<Individual>(*this, geneticCode));
+            Individuals.Add(Pool.Create(*this, geneticCode), -1, -1, 0, GlobalSettings::MaxVitality / 2);
         }
 
         // Assign random positions and set balances to 1 
         // so that every individual returns one food tile to the
         // environment.
-        for (auto& individual : Individuals)
+        for (auto row = 0; row < Individuals.Size(); ++row)
         {
             auto newX = GlobalSettings::DistanceStep * (distWidth(GlobalSettings::RNG) / GlobalSettings::DistanceStep);
             auto newY = GlobalSettings::DistanceStep * (distHeight(GlobalSettings::RNG) / GlobalSettings::DistanceStep);
 
-            while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), Regions))
+            while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), RegionRaster))
             {
                 newX = GlobalSettings::DistanceStep * (distWidth(GlobalSettings::RNG) / GlobalSettings::DistanceStep);
                 newY = GlobalSettings::DistanceStep * (distHeight(GlobalSettings::RNG) / GlobalSettings::DistanceStep);
             }
 
-            individual->X = newX;
-            individual->Y = newY;
+            Individuals.X[row] = newX;
+            Individuals.Y[row] = newY;
         }
+
+        PositionsCurrent = false;
     }
 
 
     void Environment::AddRegion(cv::Rect region, float probability)
     {
+        RegionRaster.Add(region, int(Regions.size()));
         Regions.push_back(region);
+        Tiles.Reset(Map, RegionRaster, int(Regions.size()));
         InitialRegionActiveTiles.push_back(probability * region.area());
-        NumActiveTilesToAdd.push_back(0);
     }
 
 
@@ -79,11 +112,11 @@ namespace ABME
     void Environment::CapturePopulation()
     {
         // Clear current contents.
-        Captured.clear();
+        Captured.Clear();
 
-        for (auto& ind : Individuals)
+        for (auto row = 0; row < Individuals.Size(); ++row)
         {
-            Captured.push_back(std::unique_ptr<Individual>(ind->Clone(true)));
+            Captured.Add(Individuals[row].Clone(true), Individuals.X[row], Individuals.Y[row], Individuals.Age[row], Individuals.Vitality[row]);
         }
 
         PopulationCaptured = true;
@@ -94,14 +127,13 @@ namespace ABME
     /// point in time) a number of tiles.
     int Environment::CauseTileCrisis(int numTilesToAdd)
     {
-        auto activeTiles = CountActiveTiles(false);
+        auto activeTiles = CountActiveTiles();
         auto inactiveTiles = 0;
         
-        for (auto& r : Regions)
+        for (auto i = 0; i < Regions.size(); ++i)
         {
-            inactiveTiles += r.area(); 
+            inactiveTiles += Tiles.Count(i, false);
         }
-        inactiveTiles -= activeTiles;
 
         // Clamp the number of tiles to add.
         numTilesToAdd = std::min(inactiveTiles, std::max(numTilesToAdd, -activeTiles));
@@ -115,49 +147,30 @@ namespace ABME
     /// Clamps positions to environment maximum dimensions (and barcode margin).
     void Environment::ClampPositions(int& x, int& y) const
     {
-        x = std::max(0, std::min(Map.cols - GlobalSettings::BarcodeSize, x));
-        y = std::max(0, std::min(Map.rows - GlobalSettings::BarcodeSize, y));
+        x = std::max(0, std::min(Map.GetWidth() - GlobalSettings::BarcodeSize, x));
+        y = std::max(0, std::min(Map.GetHeight() - GlobalSettings::BarcodeSize, y));
     }
 
 
-    /// Returns the number of active tiles in the map.
-    /// If includeBoundBalance is true, it also adds the number of "tiles" 
-    /// bound to the population.
+    /// Returns the number of active tiles in the map (within regions).
     int Environment::CountActiveTiles() const
     {
-        int count = 0;
-        for (auto i = 0; i < Regions.size(); ++i)
-        {
-            count += CountActiveTiles(i);
-        }
-
-        return count;
+        return Tiles.CountActive();
     }
 
 
     /// Only counts the active tiles in a region.
     int Environment::CountActiveTiles(int regionIndex) const
     {
-        int count = 0;
-        auto& region = Regions[regionIndex];
-
-        for (auto i = region.x; i < region.x + region.width; ++i)
-        {
-            for (auto j = region.y; j < region.y + region.height; ++j)
-            {
-                if (Map.at<uchar>(j, i) == 255) ++count;
-            }
-        }
-
-        return count;
+        return Tiles.Count(regionIndex, true);
     }
 
 
     void Environment::Draw(std::string& windowName) const
     {
         // Convert from gayscale to color.
-        Mat drawMap = cv::Mat(Map.rows, Map.cols, CV_8UC4);
-        cv::cvtColor(Map, drawMap, cv::COLOR_GRAY2BGRA);
+        Mat drawMap = cv::Mat(Map.GetHeight(), Map.GetWidth(), CV_8UC4);
+        cv::cvtColor(Map.ToMat(), drawMap, cv::COLOR_GRAY2BGRA);
 
         // Depending on draw mode, colour it.
         switch (drawMode)
@@ -167,17 +180,17 @@ namespace ABME
             // Get chromosome length range.
             int min = INT_MAX;
             int max = 0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->Age);
-                max = std::max(max, ind->Age);
+                min = std::min(min, Individuals.Age[row]);
+                max = std::max(max, Individuals.Age[row]);
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * float(ind->Age - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * float(Individuals.Age[row] - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -186,17 +199,17 @@ namespace ABME
             // Get chromosome length range.
             size_t min = INT_MAX;
             size_t max = 0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.Length());
-                max = std::max(max, ind->ItsGeneticCode.Length());
+                min = std::min(min, Individuals[row].ItsGeneticCode.Length());
+                max = std::max(max, Individuals[row].ItsGeneticCode.Length());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * float(ind->ItsGeneticCode.Length() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * float(Individuals[row].ItsGeneticCode.Length() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -205,17 +218,17 @@ namespace ABME
             // Get chromosome length range.
             double min = DBL_MAX;
             double max = 0.0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate());
-                max = std::max(max, ind->ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate());
+                min = std::min(min, Individuals[row].ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate());
+                max = std::max(max, Individuals[row].ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * double(ind->ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * double(Individuals[row].ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -224,17 +237,17 @@ namespace ABME
             // Get chromosome length range.
             double min = DBL_MAX;
             double max = 0.0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.BehaviourGenes.GetFlipMutationRate());
-                max = std::max(max, ind->ItsGeneticCode.BehaviourGenes.GetFlipMutationRate());
+                min = std::min(min, Individuals[row].ItsGeneticCode.BehaviourGenes.GetFlipMutationRate());
+                max = std::max(max, Individuals[row].ItsGeneticCode.BehaviourGenes.GetFlipMutationRate());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * double(ind->ItsGeneticCode.BehaviourGenes.GetFlipMutationRate() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * double(Individuals[row].ItsGeneticCode.BehaviourGenes.GetFlipMutationRate() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -243,17 +256,17 @@ namespace ABME
             // Get chromosome length range.
             double min = DBL_MAX;
             double max = 0.0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate());
-                max = std::max(max, ind->ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate());
+                min = std::min(min, Individuals[row].ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate());
+                max = std::max(max, Individuals[row].ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * double(ind->ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * double(Individuals[row].ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -262,17 +275,17 @@ namespace ABME
             // Get chromosome length range.
             double min = DBL_MAX;
             double max = 0.0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.BehaviourGenes.GetTransMutationRate());
-                max = std::max(max, ind->ItsGeneticCode.BehaviourGenes.GetTransMutationRate());
+                min = std::min(min, Individuals[row].ItsGeneticCode.BehaviourGenes.GetTransMutationRate());
+                max = std::max(max, Individuals[row].ItsGeneticCode.BehaviourGenes.GetTransMutationRate());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * double(ind->ItsGeneticCode.BehaviourGenes.GetTransMutationRate() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * double(Individuals[row].ItsGeneticCode.BehaviourGenes.GetTransMutationRate() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -281,17 +294,17 @@ namespace ABME
             // Get chromosome length range.
             double min = DBL_MAX;
             double max = 0.0;
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                min = std::min(min, ind->ItsGeneticCode.GetMetaMutationRate());
-                max = std::max(max, ind->ItsGeneticCode.GetMetaMutationRate());
+                min = std::min(min, Individuals[row].ItsGeneticCode.GetMetaMutationRate());
+                max = std::max(max, Individuals[row].ItsGeneticCode.GetMetaMutationRate());
             }
 
-            for (auto& ind : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                int redLevel = max > min ? 255 * double(ind->ItsGeneticCode.GetMetaMutationRate() - min) / (max - min) : 128;
+                int redLevel = max > min ? 255 * double(Individuals[row].ItsGeneticCode.GetMetaMutationRate() - min) / (max - min) : 128;
                 int blueLevel = 255 - redLevel;
-                rectangle(drawMap, Rect(ind->X, ind->Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
+                rectangle(drawMap, Rect(Individuals.X[row], Individuals.Y[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), cv::Scalar(blueLevel, 0, redLevel, 64));
             }
         }
         break;
@@ -303,18 +316,127 @@ namespace ABME
     }
 
 
-    cv::Mat& Environment::GetMap()
+    /// Removes the live individuals anchored above world row top or from world
+    /// row bottom on, writing them (with their state) to a message for each
+    /// side. The dead stay for the end of the step to remove.
+    void Environment::Emigrate(int top, int bottom, std::vector<uchar>& up, std::vector<uchar>& down)
+    {
+        MessageWriter upwards, downwards;
+        std::vector<char> leaving(Individuals.Size(), 0);
+        for (auto row = 0; row < Individuals.Size(); ++row)
+        {
+            const auto y = Origin + Individuals.Y[row];
+            if (!Individuals.Alive[row] || (y >= top && y < bottom)) continue;
+
+            auto& message = y < top ? upwards : downwards;
+            Individuals[row].ItsGeneticCode.Write(message);
+            message.Write(Individuals.X[row]);
+            message.Write(y);
+            message.Write(Individuals.Age[row]);
+            message.Write(Individuals.Vitality[row]);
+            message.Write(Individuals.Barcodes[row]);
+
+            leaving[row] = 1;
+            if (Individuals.SnapshotX[row] >= 0) MarkChanged(Rect(Individuals.SnapshotX[row], Individuals.SnapshotY[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize));
+        }
+
+        Individuals.RemoveWhere(leaving, 1);
+        PositionsCurrent = false;
+
+        up = std::move(upwards.Bytes);
+        down = std::move(downwards.Bytes);
+    }
+
+
+    /// Returns the most common genomes (by their genes alone), most common first.
+    std::vector<GeneticCode<ushort>> Environment::GetDominantGenomes(int count) const
+    {
+        std::map<std::pair<std::uint64_t, std::uint64_t>, std::pair<int, int>> genomes; // Fingerprints to (individuals, first row).
+        for (auto row = 0; row < Individuals.Size(); ++row)
+        {
+            auto& geneticCode = Individuals[row].ItsGeneticCode;
+            auto& genome = genomes[{ geneticCode.BehaviourGenes.Rules.Fingerprint, geneticCode.InteractionGenes.Rules.Fingerprint }];
+            if (genome.first++ == 0) genome.second = row;
+        }
+
+        std::vector<std::pair<int, int>> ranked;
+        for (auto& [fingerprints, genome] : genomes) ranked.push_back(genome);
+        std::sort(ranked.begin(), ranked.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+        std::vector<GeneticCode<ushort>> dominant;
+        for (auto i = 0; i < std::min(count, int(ranked.size())); ++i) dominant.push_back(Individuals[ranked[i].second].ItsGeneticCode);
+
+        return dominant;
+    }
+
+
+    const Population& Environment::GetIndividuals() const
+    {
+        return Individuals;
+    }
+
+
+    const PackedMap& Environment::GetMap() const
     {
         return Map;
     }
 
 
+    int Environment::GetOrigin() const
+    {
+        return Origin;
+    }
+
+
+    IndividualPool& Environment::GetPool()
+    {
+        return Pool;
+    }
+
+
+    /// Returns the positions of all individuals at the end of the last update,
+    /// indexing them first if they changed since the last index was built.
+    const SpatialGrid& Environment::GetPositions() const
+    {
+        if (!PositionsCurrent) IndexPositions();
+        return Positions;
+    }
+
+
+    const RegionMap& Environment::GetRegionMap() const
+    {
+        return RegionRaster;
+    }
+
+
     std::vector<Rect>& Environment::GetRegions()
     {
         return Regions;
     }
 
 
+    /// Adds the individuals written by another environment's Emigrate.
+    void Environment::Immigrate(const std::vector<uchar>& message)
+    {
+        MessageReader reader(message);
+        while (!reader.AtEnd())
+        {
+            GeneticCode<ushort> geneticCode;
+            geneticCode.Read(reader);
+            const auto x = reader.Read<int>();
+            const auto y = reader.Read<int>();
+            const auto age = reader.Read<int>();
+            const auto vitality = reader.Read<int>();
+
+            const auto handle = Pool.Create(*this, geneticCode);
+            Pool.Get(handle)->CurrentBarcode.SetBits(reader.Read<BarcodeBits>());
+            Individuals.Add(handle, x, y - Origin, age, vitality);
+        }
+
+        PositionsCurrent = false;
+    }
+
+
     void Environment::Initialise(std::map<int, int> lengthCounts, bool useSameGeneIndices, bool useSimpleGenesFirst)
     {
         for (auto&[length, count] : lengthCounts)
@@ -327,9 +449,149 @@ namespace ABME
     }
 
 
-    void Environment::RegisterActiveTileAddition(int regionIndex, int numTiles)
+    /// The second half of a step: individuals move randomly, those sharing a
+    /// position interact, and the dead are removed.
+    void Environment::Interact()
+    {
+        static int killed = 0; 
+        static int born = 0; 
+        static int diedNaturally = 0;
+
+        std::uniform_int_distribution<std::mt19937::result_type> dist(0, 2 * GlobalSettings::DistanceStep);
+
+        // Register survivors' positions for colocations. This is the one
+        // index built per step; queries between steps rebuild it on demand.
+        IndexPositions();
+
+        // The dead stay in place (out of the colocations) until the single
+        // removal pass at the end of the step.
+        auto naturalDeaths = 0;
+        for (auto row = 0; row < Individuals.Size(); ++row)
+        {
+            if (!Individuals.Alive[row]) ++naturalDeaths;
+
+            // Add random ("Brownian") motion.
+            const auto x = Individuals.X[row];
+            const auto y = Individuals.Y[row];
+            int newX = x + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+            int newY = y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+            ClampPositions(newX, newY);
+
+            while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), RegionRaster))
+            {
+                newX = x + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                newY = y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                ClampPositions(newX, newY);
+            }
+
+            Individuals.X[row] = newX;
+            Individuals.Y[row] = newY;
+        }
+
+        // Interact colocations. Groups are disjoint, so they run concurrently,
+        // each drawing from a stream keyed by its cell; newborns are queued per
+        // thread and merged in group order, so the outcome is independent of
+        // the scheduling.
+        const auto colocations = Positions.FindColocations();
+        std::vector<std::vector<std::pair<int, Offspring>>> birthQueues(omp_get_max_threads());
+
+#pragma omp parallel for schedule(dynamic)
+        for (int group = 0; group < int(colocations.size()); ++group)
+        {
+            auto& colocated = colocations[group];
+            const auto members = Resolve(colocated.Members);
+            RandomStream rng(GetStreamSeed(RandomPhaseInteraction, std::uint64_t(Origin + colocated.Y) * Map.GetWidth() + colocated.X));
+            std::uniform_int_distribution<int> offset(0, 2 * GlobalSettings::DistanceStep);
+
+            // Interact 'em!
+            for (auto& offspring : Interactor::Interact(members, rng))
+            {
+                int newX = offspring.X + GlobalSettings::DistanceStep * ((offset(rng) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                int newY = offspring.Y + GlobalSettings::DistanceStep * ((offset(rng) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                ClampPositions(newX, newY);
+
+                while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), RegionRaster))
+                {
+                    newX = offspring.X + GlobalSettings::DistanceStep * ((offset(rng) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                    newY = offspring.Y + GlobalSettings::DistanceStep * ((offset(rng) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
+                    ClampPositions(newX, newY);
+                }
+
+                offspring.X = newX;
+                offspring.Y = newY;
+
+                birthQueues[omp_get_thread_num()].emplace_back(group, offspring);
+            }
+        }
+
+        // Add the newborns to our list.
+        std::vector<std::pair<int, Offspring>> births;
+        for (auto& queue : birthQueues) births.insert(births.end(), queue.begin(), queue.end());
+        std::stable_sort(births.begin(), births.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        born += int(births.size());
+        for (auto& [group, offspring] : births) Individuals.Add(offspring.Handle, offspring.X, offspring.Y, 0, offspring.Vitality);
+
+        // Remove the dead: natural deaths and those killed in interactions.
+        for (auto row = 0; row < Individuals.Size(); ++row)
+        {
+            if (!Individuals.Alive[row] && Individuals.SnapshotX[row] >= 0) MarkChanged(Rect(Individuals.SnapshotX[row], Individuals.SnapshotY[row], GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize));
+        }
+
+        const auto removed = Individuals.RemoveDead();
+        diedNaturally += naturalDeaths;
+        killed += removed - naturalDeaths;
+
+        // Log some interesting metrics.
+        RunMetrics(killed, born, diedNaturally);
+
+        // Individuals have moved, been born and died since the index was built.
+        PositionsCurrent = false;
+
+        ++StepCount;
+    }
+
+
+    /// Writes the position and barcode of every live individual anchored from
+    /// world row top to world row bottom, for another environment's SetNeighbours.
+    std::vector<uchar> Environment::ListBarcodes(int top, int bottom) const
     {
-        NumActiveTilesToAdd[regionIndex] += numTiles;
+        MessageWriter message;
+        for (auto row = 0; row < Individuals.Size(); ++row)
+        {
+            const auto y = Origin + Individuals.Y[row];
+            if (!Individuals.Alive[row] || y < top || y >= bottom) continue;
+
+            message.Write(Individuals.X[row]);
+            message.Write(y);
+            message.Write(Individuals.Barcodes[row]);
+        }
+
+        return std::move(message.Bytes);
+    }
+
+
+    /// Records that tiles in the area changed, for the next snapshot update.
+    /// Individuals updated concurrently mark disjoint blocks, as blocks are the
+    /// size of a barcode (see UpdateIndividuals), so no locking is needed.
+    void Environment::MarkChanged(const cv::Rect& area)
+    {
+        const auto clipped = area & Rect(0, 0, Map.GetWidth(), Map.GetHeight());
+        if (clipped.empty()) return;
+
+        const auto size = GlobalSettings::BarcodeSize;
+        auto& changed = SnapshotChangedBlocks[omp_get_thread_num()];
+        for (auto by = clipped.y / size; by <= (clipped.y + clipped.height - 1) / size; ++by)
+        {
+            for (auto bx = clipped.x / size; bx <= (clipped.x + clipped.width - 1) / size; ++bx)
+            {
+                auto& flag = SnapshotBlockChanged[by * SnapshotBlocksPerRow + bx];
+                if (flag) continue;
+
+                flag = 1;
+                changed.push_back(by * SnapshotBlocksPerRow + bx);
+            }
+        }
     }
 
 
@@ -337,10 +599,12 @@ namespace ABME
     {
         // Copy the captured population onto the vector of individuals,
         // but maintain the list for future releases.
-        for (auto& ind : Captured)
+        for (auto row = 0; row < Captured.Size(); ++row)
         {
-            Individuals.push_back(std::unique_ptr<Individual>(ind->Clone(true)));
+            Individuals.Add(Captured[row].Clone(true), Captured.X[row], Captured.Y[row], Captured.Age[row], Captured.Vitality[row]);
         }
+
+        PositionsCurrent = false;
     }
 
 
@@ -355,7 +619,7 @@ namespace ABME
             std::cout << std::setprecision(4);
 
             std::stringstream log;
-            log << i << "] Num. individuals = " << Individuals.size() << "(" << born << " born this cycle, " << killed << " killed, " << diedNaturally << " died naturally)" << std::endl;
+            log << i << "] Num. individuals = " << Individuals.Size() << "(" << born << " born this cycle, " << killed << " killed, " << diedNaturally << " died naturally)" << std::endl;
             std::map<int, int> genePoolBehaviour;
             std::map<int, int> genePoolInteraction;
             std::map<int, int> genePool;
@@ -367,42 +631,43 @@ namespace ABME
             double mrtBehaviour = 0, mrtInteraction = 0;
             double mrm = 0;
             double mrfParams = 0;
-            for (auto& individual : Individuals)
+            for (auto row = 0; row < Individuals.Size(); ++row)
             {
-                genePoolBehaviour[individual->ItsGeneticCode.BehaviourGenes.Length()]++;
-                genePoolInteraction[individual->ItsGeneticCode.InteractionGenes.Length()]++;
-                genePool[individual->ItsGeneticCode.Length()]++;
-
-                age += individual->Age;
-                reproductiveAge += individual->ItsGeneticCode.ReproductiveAge;
-                programmedDeath += individual->ItsGeneticCode.ProgrammedLifespan;
+                const auto& individual = Individuals[row];
+                genePoolBehaviour[individual.ItsGeneticCode.BehaviourGenes.Length()]++;
+                genePoolInteraction[individual.ItsGeneticCode.InteractionGenes.Length()]++;
+                genePool[individual.ItsGeneticCode.Length()]++;
+
+                age += Individuals.Age[row];
+                reproductiveAge += individual.ItsGeneticCode.ReproductiveAge;
+                programmedDeath += individual.ItsGeneticCode.ProgrammedLifespan;
                 
-                mrfBehaviour += individual->ItsGeneticCode.BehaviourGenes.GetFlipMutationRate();
-                mriBehaviour += individual->ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate();
-                mrdBehaviour += individual->ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate();
-                mrtBehaviour += individual->ItsGeneticCode.BehaviourGenes.GetTransMutationRate();
+                mrfBehaviour += individual.ItsGeneticCode.BehaviourGenes.GetFlipMutationRate();
+                mriBehaviour += individual.ItsGeneticCode.BehaviourGenes.GetInsertionMutationRate();
+                mrdBehaviour += individual.ItsGeneticCode.BehaviourGenes.GetDeletionMutationRate();
+                mrtBehaviour += individual.ItsGeneticCode.BehaviourGenes.GetTransMutationRate();
                 
-                mrfInteraction += individual->ItsGeneticCode.InteractionGenes.GetFlipMutationRate();
-                mriInteraction += individual->ItsGeneticCode.InteractionGenes.GetInsertionMutationRate();
-                mrdInteraction += individual->ItsGeneticCode.InteractionGenes.GetDeletionMutationRate();
-                mrtInteraction += individual->ItsGeneticCode.InteractionGenes.GetTransMutationRate();
+                mrfInteraction += individual.ItsGeneticCode.InteractionGenes.GetFlipMutationRate();
+                mriInteraction += individual.ItsGeneticCode.InteractionGenes.GetInsertionMutationRate();
+                mrdInteraction += individual.ItsGeneticCode.InteractionGenes.GetDeletionMutationRate();
+                mrtInteraction += individual.ItsGeneticCode.InteractionGenes.GetTransMutationRate();
                 
-                mrm += individual->ItsGeneticCode.GetMetaMutationRate();
-                mrfParams += individual->ItsGeneticCode.GetFlipMutationRate();
+                mrm += individual.ItsGeneticCode.GetMetaMutationRate();
+                mrfParams += individual.ItsGeneticCode.GetFlipMutationRate();
             }
-            age /= Individuals.size();
-            reproductiveAge /= Individuals.size();
-            programmedDeath /= Individuals.size();
-            mrfBehaviour /= Individuals.size();
-            mriBehaviour /= Individuals.size();
-            mrdBehaviour /= Individuals.size();
-            mrtBehaviour /= Individuals.size();
-            mrfInteraction /= Individuals.size();
-            mriInteraction /= Individuals.size();
-            mrdInteraction /= Individuals.size();
-            mrtInteraction /= Individuals.size();
-            mrm /= Individuals.size();
-            mrfParams /= Individuals.size();
+            age /= Individuals.Size();
+            reproductiveAge /= Individuals.Size();
+            programmedDeath /= Individuals.Size();
+            mrfBehaviour /= Individuals.Size();
+            mriBehaviour /= Individuals.Size();
+            mrdBehaviour /= Individuals.Size();
+            mrtBehaviour /= Individuals.Size();
+            mrfInteraction /= Individuals.Size();
+            mriInteraction /= Individuals.Size();
+            mrdInteraction /= Individuals.Size();
+            mrtInteraction /= Individuals.Size();
+            mrm /= Individuals.Size();
+            mrfParams /= Individuals.Size();
 
             float lengthOverall = 0.f, lengthBehaviour = 0.f, lengthInteraction = 0.f;
             for (auto&[length, count] : genePool)
@@ -421,9 +686,9 @@ namespace ABME
                 lengthInteraction += length * count;
             }
 
-            lengthOverall /= Individuals.size();
-            lengthBehaviour /= Individuals.size();
-            lengthInteraction /= Individuals.size();
+            lengthOverall /= Individuals.Size();
+            lengthBehaviour /= Individuals.Size();
+            lengthInteraction /= Individuals.Size();
 
             log << "\n[Overall] Avg. chromosome length: " << lengthOverall << std::endl;
             log << "[Behaviour] Avg. chromosome length: " << lengthBehaviour << std::endl;
@@ -441,10 +706,15 @@ namespace ABME
             log << "[Interaction] Avg. mut. rate (trans.): " << mrtInteraction << std::endl;
             log << "\n[Params] Avg. mut. rate (flip): " << mrfParams << std::endl;
             log << "Avg. mut. rate (meta): " << mrm << std::endl;
+            log << "\nIndividual pool: " << Pool.GetStatistics() << std::endl;
+            log << "Active tiles: " << CountActiveTiles() << " (" << Tiles.GetStatistics() << ")" << std::endl;
+            log << "World map: " << Map.GetStatistics() << "; snapshot: " << Snapshot.GetStatistics() << "; regions: " << RegionRaster.GetStatistics() << std::endl;
+            if (GlobalSettings::UseTransitionCache) log << "Transition cache: " << TransitionCache::Instance().GetStatistics() << std::endl;
+            if (GlobalSettings::UseInteractionCache) log << "Interaction cache: " << InteractionCache::Instance().GetStatistics() << std::endl;
 
             // Report most popular genes.
             std::vector<GeneSet> chromosomesBehaviour, chromosomesInteraction;
-            for (auto& ind : Individuals) chromosomesBehaviour.push_back(ind->ItsGeneticCode.BehaviourGenes.Genes);
+            for (auto row = 0; row < Individuals.Size(); ++row) chromosomesBehaviour.push_back(Individuals[row].ItsGeneticCode.BehaviourGenes.Genes.ToGeneSet());
             //for (auto& ind : Individuals) chromosomesInteraction.push_back(ind->ItsGeneticCode.BehaviourGenes.Genes);
 
             auto geneCountSet = Helpers::GeneStatistics(chromosomesBehaviour);
@@ -458,7 +728,7 @@ namespace ABME
             }
             log << std::endl;
 
-            if (Captured.size() > 0)
+            if (Captured.Size() > 0)
             {
                 log << "\nPopulation captured. Press r to release.\n";
             }
@@ -475,6 +745,28 @@ namespace ABME
     }
 
 
+    /// Replaces the barcodes of other environments' individuals burnt into the
+    /// snapshot (so this environment's individuals sense them) by those written
+    /// by ListBarcodes. Neighbours only show in the snapshot; they are not updated.
+    void Environment::SetNeighbours(const std::vector<uchar>& message)
+    {
+        for (auto& neighbour : Neighbours) MarkChanged(Rect(neighbour.X, neighbour.Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize));
+        Neighbours.clear();
+
+        MessageReader reader(message);
+        while (!reader.AtEnd())
+        {
+            Neighbour neighbour;
+            neighbour.X = reader.Read<int>();
+            neighbour.Y = reader.Read<int>() - Origin;
+            neighbour.Barcode = reader.Read<BarcodeBits>();
+            Neighbours.push_back(neighbour);
+
+            MarkChanged(Rect(neighbour.X, neighbour.Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize));
+        }
+    }
+
+
     void Environment::ToggleDrawMode()
     {
         switch (drawMode)
@@ -515,231 +807,279 @@ namespace ABME
     }
 
 
+    /// Steps the environment: Act, then Interact.
     void Environment::Update()
     {
-        static int killed = 0; 
-        static int born = 0; 
-        static int diedNaturally = 0;
+        Act();
+        Interact();
+    }
 
-        std::uniform_int_distribution<std::mt19937::result_type> dist(0, 2 * GlobalSettings::DistanceStep);
 
-        // Take an additive snapshot of the world + barcodes.
-        Snapshot = Map.clone();
-        for (auto& individual : Individuals)
+    /// Activates or deactivates a tile. Every change to the map goes through
+    /// here, so the snapshot, the tile sets and their ledgers follow it.
+    /// While the individuals are updated in parallel (writing disjoint tiles)
+    /// the tile is filed in its set afterwards; otherwise straight away.
+    void Environment::WriteTile(int x, int y, bool active, TileSource source)
+    {
+        if (!Map.Set(x, y, active)) return;
+
+        MarkChanged(Rect(x, y, 1, 1));
+
+        if (DeferTileFiling) ChangedTiles[omp_get_thread_num()].emplace_back(y * Map.GetWidth() + x, source);
+        else Tiles.Set(x, y, active, source);
+    }
+
+
+    /// Writes a barcode-sized patch of tiles (1 for active) anchored at (x, y).
+    void Environment::WriteTiles(int x, int y, const std::string& tiles, TileSource source)
+    {
+        for (auto i = 0; i < int(tiles.size()); ++i)
         {
-            BurnBarcode(Snapshot, *individual);
+            WriteTile(x + i % GlobalSettings::BarcodeSize, y + i / GlobalSettings::BarcodeSize, tiles[i] == 1, source);
         }
+    }
 
-        // Update all individuals.
-        for (int i = 0; i < Individuals.size(); ++i)
-        {
-            auto& individual = Individuals[i];
-            individual->Update(Snapshot, Colocations);
-            
-            // Add random ("Brownian") motion.
-            int newX = individual->X + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-            int newY = individual->Y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-            ClampPositions(newX, newY);
 
-            while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), Regions))
-            {
-                newX = individual->X + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                newY = individual->Y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                ClampPositions(newX, newY);
-            }
+    Individual& Environment::operator[](int index)
+    {
+        return Individuals[index];
+    }
+
+
+    void Environment::InitialiseTiles()
+    {
+        std::uniform_real_distribution<> dist(0.0, 1.0);
 
-            individual->X = newX;
-            individual->Y = newY;
+        for (auto i = 0; i < Regions.size(); ++i)
+        {
+            GenerateRandomTiles(i, InitialRegionActiveTiles[i]);
         }
+    }
+
 
-        // Remove dead individuals.
-        for (auto it = Individuals.begin(); it != Individuals.end();)
+    /// Files the tiles written during the parallel update in their sets,
+    /// each as last written. The tiles are filed in map order, so the sets do
+    /// not depend on which thread wrote what.
+    void Environment::ApplyChangedTiles()
+    {
+        std::vector<std::pair<int, TileSource>> changed;
+        for (auto& tiles : ChangedTiles)
         {
-            if (!(*it)->IsAlive())
-            {
-                it = Individuals.erase(it);
-                ++diedNaturally;
-            }
-            else
-            {
-                ++it;
-            }
+            changed.insert(changed.end(), tiles.begin(), tiles.end());
+            tiles.clear();
         }
 
-        // Interact colocations.
-        for (auto it = Colocations.begin(), end = Colocations.end(); it != end; it = Colocations.upper_bound(it->first))
+        std::stable_sort(changed.begin(), changed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (size_t i = 0; i < changed.size(); ++i)
         {
-            auto& location = it->first;
-            auto count = Colocations.count(location);
-            if (count > 1)
-            {
-                auto individuals = Colocations.equal_range(location);
-                std::vector<Individual*> colocated;
-                for (auto it2 = individuals.first; it2 != individuals.second; ++it2)
-                {
-                    colocated.push_back(it2->second);
-                }
+            if (i + 1 < changed.size() && changed[i + 1].first == changed[i].first) continue;
 
-                // Interact 'em!
-                auto newIndividuals = Interactor::Interact(colocated);
-                if (newIndividuals.size() > 0)
-                {
-                    // Add the individuals to our list.
-                    born += newIndividuals.size();
-                    for (auto& individual : newIndividuals)
-                    { 
-                        int newX = individual->X + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                        int newY = individual->Y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                        ClampPositions(newX, newY);
-
-                        while (Individual::DetectCollision(Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize), Regions))
-                        {
-                            newX = individual->X + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                            newY = individual->Y + GlobalSettings::DistanceStep * (((int)dist(GlobalSettings::RNG) - GlobalSettings::DistanceStep) / GlobalSettings::DistanceStep);
-                            ClampPositions(newX, newY);
-                        }
-
-                        individual->X = newX;
-                        individual->Y = newY;
-
-                        Individuals.push_back(std::unique_ptr<Individual>(individual));
-                    }
-                }
-            }
+            const auto x = changed[i].first % Map.GetWidth();
+            const auto y = changed[i].first / Map.GetWidth();
+            Tiles.Set(x, y, Map.Get(x, y), changed[i].second);
         }
 
-        // Remove more dead individuals.
-        for (auto it = Individuals.begin(); it != Individuals.end();)
+        Map.ReleaseEmpty();
+    }
+
+
+    /// Generates (or removes) a specific number of food tiles in a region,
+    /// depending on the sign of the argument, as many as the region has room
+    /// for.
+    void Environment::GenerateRandomTiles(int regionIndex, int numTilesToAdd)
+    {
+        const auto active = numTilesToAdd < 0;
+        numTilesToAdd = std::min(std::abs(numTilesToAdd), Tiles.Count(regionIndex, active));
+
+        for (auto i = 0; i < numTilesToAdd; ++i)
         {
-            if (!(*it)->IsAlive())
-            {
-                it = Individuals.erase(it);
-                ++killed;
-            }
-            else
-            {
-                ++it;
-            }
+            const auto tile = Tiles.Pick(regionIndex, active, GlobalSettings::RNG);
+            WriteTile(tile % Map.GetWidth(), tile / Map.GetWidth(), !active, TileSourceGeneration);
         }
 
-        // Log some interesting metrics.
-        RunMetrics(killed, born, diedNaturally);
+        Map.ReleaseEmpty();
+    }
 
-        // Clear colocations.
-        Colocations.clear();
+    
+    /// Generates (or removes) tiles randomly all over the map (within regions
+    /// only), each region drawn in proportion to the tiles it can flip.
+    void Environment::GenerateRandomTiles(int numTilesToAdd)
+    {
+        const auto active = numTilesToAdd < 0;
+        for (auto i = std::abs(numTilesToAdd); i > 0; --i)
+        {
+            auto candidates = 0;
+            for (auto r = 0; r < Regions.size(); ++r) candidates += Tiles.Count(r, active);
+            if (candidates == 0) break;
+
+            std::uniform_int_distribution<int> dist(0, candidates - 1);
+            auto pick = dist(GlobalSettings::RNG);
+            auto regionIndex = 0;
+            while (pick >= Tiles.Count(regionIndex, active)) pick -= Tiles.Count(regionIndex++, active);
+
+            const auto tile = Tiles.Pick(regionIndex, active, GlobalSettings::RNG);
+            WriteTile(tile % Map.GetWidth(), tile / Map.GetWidth(), !active, TileSourceGeneration);
+        }
+
+        Map.ReleaseEmpty();
     }
 
 
-    Individual& Environment::operator[](int index)
+    /// Seeds the random stream of a key (an individual or a cell) in a phase of
+    /// this step, so draws do not depend on which thread handles the key.
+    std::uint64_t Environment::GetStreamSeed(RandomPhase phase, std::uint64_t key) const
     {
-        return *Individuals[index];
+        const auto stepSeed = Helpers::HashCombine(std::uint64_t(GlobalSettings::Seed), StepCount);
+        return Helpers::HashCombine(Helpers::HashCombine(stepSeed, phase), key);
     }
 
 
-    void Environment::InitialiseTiles()
+    /// Indexes the positions of all live individuals.
+    void Environment::IndexPositions() const
     {
-        std::uniform_real_distribution<> dist(0.0, 1.0);
-
-        for (auto i = 0; i < Regions.size(); ++i)
+        Positions.Reset(Map.GetWidth(), Map.GetHeight());
+        for (auto row = 0; row < Individuals.Size(); ++row)
         {
-            GenerateRandomTiles(Regions[i], InitialRegionActiveTiles[i]);
+            if (Individuals.Alive[row]) Positions.Insert(Individuals.X[row], Individuals.Y[row], Individuals.Handles[row]);
         }
+
+        Positions.Build();
+        PositionsCurrent = true;
     }
 
 
-    /// Generates (or removes) a specific number of foot tiles, depending
-    /// on the sign of the argument.
-    /// Warning! This will hang the application if it does not find an empty/food tile.
-    void Environment::GenerateRandomTiles(cv::Rect& region, int numTilesToAdd)
+    std::vector<Individual*> Environment::Resolve(const std::vector<IndividualHandle>& handles) const
     {
-        std::uniform_int_distribution<std::mt19937::result_type> distWidth(region.x, region.x + region.width - 1);
-        std::uniform_int_distribution<std::mt19937::result_type> distHeight(region.y, region.y + region.height - 1);
+        std::vector<Individual*> individuals(handles.size());
+        std::transform(handles.begin(), handles.end(), individuals.begin(), [this](IndividualHandle handle) { return Pool.Get(handle); });
+        return individuals;
+    }
 
-        while (numTilesToAdd > 0)
+
+    /// Updates all individuals concurrently. An individual writes the world under
+    /// its barcode, a square of BarcodeSize tiles, so squares anchored in blocks of
+    /// BarcodeSize tiles two blocks apart never overlap. Blocks are coloured by
+    /// the parity of their coordinates: the four colours run one after another,
+    /// the blocks of a colour in parallel, and the individuals of a block in order.
+    /// Each individual draws from its own stream, seeded by the step and its
+    /// index, so the results do not depend on the number of threads.
+    void Environment::UpdateIndividuals()
+    {
+        const int blockSize = GlobalSettings::BarcodeSize;
+        const int blocksPerRow = Map.GetWidth() / blockSize + 1;
+        const int numBlocks = blocksPerRow * (Map.GetHeight() / blockSize + 1);
+        if (ChangedTiles.size() < omp_get_max_threads()) ChangedTiles.resize(omp_get_max_threads());
+        DeferTileFiling = true;
+
+        // Order the individuals by colour, then block, then index.
+        std::vector<std::pair<int, int>> order(Individuals.Size());
+        for (int i = 0; i < Individuals.Size(); ++i)
         {
-            auto x = distWidth(GlobalSettings::RNG);
-            auto y = distHeight(GlobalSettings::RNG);
-            auto& tile = Map.at<uchar>(y, x);
+            const auto blockX = Individuals.X[i] / blockSize;
+            const auto blockY = Individuals.Y[i] / blockSize;
+            const auto colour = 2 * (blockY % 2) + blockX % 2;
+            order[i] = { colour * numBlocks + blockY * blocksPerRow + blockX, i };
+        }
 
-            if (tile == 255) continue;
-            else tile = 255;
+        std::sort(order.begin(), order.end());
 
-            --numTilesToAdd;
+        std::vector<size_t> blockStarts;
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            if (k == 0 || order[k].first != order[k - 1].first) blockStarts.push_back(k);
         }
 
-        while (numTilesToAdd < 0)
+        blockStarts.push_back(order.size());
+
+        size_t colourBegin = 0;
+        for (auto colour = 0; colour < 4; ++colour)
         {
-            auto x = distWidth(GlobalSettings::RNG);
-            auto y = distHeight(GlobalSettings::RNG);
-            auto& tile = Map.at<uchar>(y, x);
+            auto colourEnd = colourBegin;
+            while (colourEnd + 1 < blockStarts.size() && order[blockStarts[colourEnd]].first / numBlocks == colour) ++colourEnd;
 
-            if (tile == 0) continue;
-            else tile = 0;
+#pragma omp parallel for schedule(dynamic)
+            for (int block = int(colourBegin); block < int(colourEnd); ++block)
+            {
+                for (auto k = blockStarts[block]; k < blockStarts[block + 1]; ++k)
+                {
+                    auto& individual = Individuals[order[k].second];
+                    individual.WorldRNG = RandomStream(GetStreamSeed(RandomPhaseWorld, order[k].second));
+                    individual.Update(Snapshot);
+                }
+            }
 
-            ++numTilesToAdd;
+            colourBegin = colourEnd;
         }
+
+        DeferTileFiling = false;
     }
 
-    
-    /// Generates tiles randomly all over the map (within regions only).
-    void Environment::GenerateRandomTiles(int numTilesToAdd)
-    {
-        if (numTilesToAdd == 0) return;
 
-        std::vector<int> relativeIndices;
-        for (auto i = 0; i < Map.cols * Map.rows; ++i)
+    /// Burns a barcode anchored at (x, y) into the map, a row at a time.
+    void Environment::BurnBarcode(PackedMap& map, int x, int y, const BarcodeBits& barcode)
+    {
+        for (auto i = 0; i < GlobalSettings::BarcodeSize; ++i)
         {
-            auto x = i % Map.cols;
-            auto y = i / Map.cols;
-            auto& tile = Map.at<uchar>(y, x);
-            if (Helpers::PointInsideRects(Point(x, y), Regions) && ((tile == 0 && numTilesToAdd > 0) || (tile == 255 && numTilesToAdd < 0))) relativeIndices.push_back(i);
+            map.OrRow(x, y + i, Helpers::GetRow(barcode, i));
         }
+    }
 
-        // Shuffle the indices.
-        std::shuffle(relativeIndices.begin(), relativeIndices.end(), GlobalSettings::RNG);
 
-        // Pick spots to deposit.
-        if (numTilesToAdd > 0)
+    /// Brings the snapshot (the map with every barcode burnt in) up to date.
+    /// Only the blocks whose tiles changed, or that a barcode left or entered,
+    /// are packed again from the map; the barcodes over them are then burnt
+    /// again. The cost follows the change, not the size of the map.
+    void Environment::UpdateSnapshot()
+    {
+        const auto size = GlobalSettings::BarcodeSize;
+        auto& rows = Individuals;
+        if (SnapshotChangedBlocks.size() < omp_get_max_threads()) SnapshotChangedBlocks.resize(omp_get_max_threads());
+
+        // Barcodes that moved or changed (or are new) leave and enter blocks.
+        for (auto row = 0; row < rows.Size(); ++row)
         {
-            for (auto i : relativeIndices)
-            {
-                auto tileX = i % Map.cols;
-                auto tileY = i / Map.cols;
+            if (rows.SnapshotX[row] == rows.X[row] && rows.SnapshotY[row] == rows.Y[row] && rows.SnapshotBarcodes[row] == rows.Barcodes[row]) continue;
 
-                // Activate tile.
-                Map.at<uchar>(tileY, tileX) = 255;
-                --numTilesToAdd;
-                if (numTilesToAdd <= 0) break;
-            }
+            if (rows.SnapshotX[row] >= 0) MarkChanged(Rect(rows.SnapshotX[row], rows.SnapshotY[row], size, size));
+            MarkChanged(Rect(rows.X[row], rows.Y[row], size, size));
         }
-        else
+
+        for (auto& changed : SnapshotChangedBlocks)
         {
-            for (auto i : relativeIndices)
+            for (auto block : changed)
             {
-                auto tileX = i % Map.cols;
-                auto tileY = i / Map.cols;
-
-                // Activate tile.
-                Map.at<uchar>(tileY, tileX) = 0;
-                ++numTilesToAdd;
-                if (numTilesToAdd >= 0) break;
+                const auto area = Rect((block % SnapshotBlocksPerRow) * size, (block / SnapshotBlocksPerRow) * size, size, size) & Rect(0, 0, Map.GetWidth(), Map.GetHeight());
+                Snapshot.Copy(Map, area);
             }
         }
-    }
 
+        // A barcode anchored in a block covers at most that block and the next ones right and down.
+        for (auto row = 0; row < rows.Size(); ++row)
+        {
+            const auto block = (rows.Y[row] / size) * SnapshotBlocksPerRow + rows.X[row] / size;
+            const auto right = (rows.X[row] + size - 1) / size != rows.X[row] / size;
+            const auto down = (rows.Y[row] + size - 1) / size != rows.Y[row] / size;
+            if (!SnapshotBlockChanged[block] &&
+                !(right && SnapshotBlockChanged[block + 1]) &&
+                !(down && SnapshotBlockChanged[block + SnapshotBlocksPerRow]) &&
+                !(right && down && SnapshotBlockChanged[block + SnapshotBlocksPerRow + 1])) continue;
+
+            BurnBarcode(Snapshot, rows.X[row], rows.Y[row], rows.Barcodes[row]);
+            rows.SnapshotX[row] = rows.X[row];
+            rows.SnapshotY[row] = rows.Y[row];
+            rows.SnapshotBarcodes[row] = rows.Barcodes[row];
+        }
 
-    void Environment::BurnBarcode(Mat& map, Individual& individual)
-    {
-        auto& barcode = individual.GetBarcodeString();
-        for (auto i = 0; i < barcode.size(); ++i)
+        // Neighbours are few and the blocks under them may have been packed again.
+        for (auto& neighbour : Neighbours) BurnBarcode(Snapshot, neighbour.X, neighbour.Y, neighbour.Barcode);
+
+        for (auto& changed : SnapshotChangedBlocks)
         {
-            uchar c = barcode[i];
-            if (c == 1)
-            {
-                int x = individual.X + (i % GlobalSettings::BarcodeSize);
-                int y = individual.Y + (i / GlobalSettings::BarcodeSize);
-                map.at<uchar>(y, x) = 255;
-            }
+            for (auto block : changed) SnapshotBlockChanged[block] = 0;
+            changed.clear();
         }
+
+        Snapshot.ReleaseEmpty();
     }
 }
@@ -2,7 +2,14 @@
 
 #include <map>
 #include <opencv2/highgui.hpp>
+#include "GeneticCode.h"
 #include "Helpers.h"
+#include "IndividualPool.h"
+#include "PackedMap.h"
+#include "Population.h"
+#include "RegionMap.h"
+#include "SpatialGrid.h"
+#include "TileSets.h"
 
 namespace ABME
 {
@@ -21,12 +28,20 @@ namespace ABME
     };
 
 
+    /// The phases of a step that draw random numbers in parallel, each from its own streams.
+    enum RandomPhase
+    {
+        RandomPhaseWorld,
+        RandomPhaseInteraction,
+    };
+
+
     class Environment
     {
     public:
-        using ColocationMapType = std::multimap<cv::Vec2i, Individual*, Vec2iComparator>;
+        Environment(int width, int height, int origin = 0);
 
-        Environment(int width, int height);
+        void Act();
 
         void AddPopulation(int numIndividuals, int geneticLength, bool useSameGeneIndices, bool useSimpleGenesFirst);
         void AddRegion(cv::Rect region, float activeProbability);
@@ -36,33 +51,71 @@ namespace ABME
         int CountActiveTiles() const;
         int CountActiveTiles(int regionIndex) const;
         void Draw(std::string& windowName) const;
-        cv::Mat& GetMap();
+        void Emigrate(int top, int bottom, std::vector<uchar>& up, std::vector<uchar>& down);
+        std::vector<GeneticCode<ushort>> GetDominantGenomes(int count) const;
+        const Population& GetIndividuals() const;
+        const PackedMap& GetMap() const;
+        int GetOrigin() const;
+        IndividualPool& GetPool();
+        const SpatialGrid& GetPositions() const;
+        const RegionMap& GetRegionMap() const;
         std::vector<cv::Rect>& GetRegions();
+        void Immigrate(const std::vector<uchar>& message);
         void Initialise(std::map<int, int> lengthCounts, bool useSameGeneIndices, bool useSimpleGenesFirst);
         void InitialiseTiles();
-        void RegisterActiveTileAddition(int regionIndex, int numTiles);
+        void Interact();
+        std::vector<uchar> ListBarcodes(int top, int bottom) const;
+        void MarkChanged(const cv::Rect& area);
         void ReleasePopulation();
         void RunMetrics(int& killed, int& born, int& diedNaturally) const;
+        void SetNeighbours(const std::vector<uchar>& message);
         void ToggleDrawMode();
         void Update();
+        void WriteTile(int x, int y, bool active, TileSource source);
+        void WriteTiles(int x, int y, const std::string& tiles, TileSource source);
 
         Individual& operator[](int index);
 
         bool PopulationCaptured = false;
 
     protected:
-        void GenerateRandomTiles(cv::Rect& region, int numTiles);
+        /// An individual of another environment, shown in the snapshot.
+        struct Neighbour
+        {
+            int X;
+            int Y;
+            BarcodeBits Barcode;
+        };
+
+        void ApplyChangedTiles();
+        void GenerateRandomTiles(int regionIndex, int numTiles);
         void GenerateRandomTiles(int numTiles);
-        void BurnBarcode(cv::Mat& map, Individual& individual);
+        void BurnBarcode(PackedMap& map, int x, int y, const BarcodeBits& barcode);
+        std::uint64_t GetStreamSeed(RandomPhase phase, std::uint64_t key) const;
+        void IndexPositions() const;
+        std::vector<Individual*> Resolve(const std::vector<IndividualHandle>& handles) const;
+        void UpdateIndividuals();
+        void UpdateSnapshot();
 
-        ColocationMapType Colocations;
-        cv::Mat Map;
-        cv::Mat Snapshot;
-        std::vector<std::unique_ptr<Individual>> Individuals;
-        std::vector<std::unique_ptr<Individual>> Captured;
+        mutable SpatialGrid Positions; // Indexed for colocations, and on demand by GetPositions.
+        mutable bool PositionsCurrent = false;
+        PackedMap Map;
+        PackedMap Snapshot; // The map with every barcode burnt in, as the individuals sense it.
+        std::vector<uchar> SnapshotBlockChanged; // Per block of BarcodeSize x BarcodeSize tiles.
+        std::vector<std::vector<int>> SnapshotChangedBlocks; // The changed blocks, listed per thread.
+        int SnapshotBlocksPerRow = 0;
+        IndividualPool Pool; // Holds the genomes and barcodes of both populations.
+        Population Individuals;
+        Population Captured;
+        std::vector<Neighbour> Neighbours; // Set by SetNeighbours, in map coordinates.
         std::vector<cv::Rect> Regions;
+        RegionMap RegionRaster; // Regions by tile, for constant-time lookups.
+        TileSets Tiles; // The active and inactive tiles of each region.
+        std::vector<std::vector<std::pair<int, TileSource>>> ChangedTiles; // Written during the parallel update, listed per thread.
+        bool DeferTileFiling = false; // Set during the parallel update.
         std::vector<int> InitialRegionActiveTiles;
-        std::vector<int> NumActiveTilesToAdd;
         DrawMode drawMode = DrawMode::DrawModeLength;
+        std::uint64_t StepCount = 0;
+        int Origin = 0; // The world row of the map's first row.
     };
 }
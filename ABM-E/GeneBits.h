@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "GlobalSettings.h"
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// A set of genes and their values as bit planes over the gene indices: a
+    /// presence bit per gene, and the low and high bits of each value (genes
+    /// with binary values only use the low plane). A genome is a few words, so
+    /// copying, comparing and recombining genomes are word-wide operations,
+    /// and the k-th gene (or the k-th absent one) is found by counting bits.
+    /// The planes only cover genes with patterns up to 3x3; 5x5 genes (when
+    /// NumGenes includes them) are too many to give a bit each, and are kept
+    /// in a sorted list instead. Genes are visited in ascending index order,
+    /// as in a GeneSet.
+    class GeneBits
+    {
+    public:
+        static constexpr int Capacity = GlobalSettings::NumGenes;
+        static constexpr int DenseCapacity = Capacity < 522 ? Capacity : 522;
+        static constexpr int NumWords = (DenseCapacity + 63) / 64;
+        using Words = std::array<std::uint64_t, NumWords>;
+
+
+        /// Visits the genes as (index, value) pairs: positions below NumWords
+        /// are words of the planes, the ones after are entries of Large.
+        class Iterator
+        {
+        public:
+            Iterator(const GeneBits& genes, int word) : Genes(genes), Word(word), Remaining(word < NumWords ? genes.Present[word] : 0)
+            {
+                Advance();
+            }
+
+
+            inline std::pair<int, uchar> operator*() const
+            {
+                if (Word >= NumWords) return Genes.Large[Word - NumWords];
+
+                const auto index = 64 * Word + Helpers::LowestBit(Remaining);
+                return { index, Genes.Get(index) };
+            }
+
+
+            inline Iterator& operator++()
+            {
+                if (Word >= NumWords) ++Word;
+                else
+                {
+                    Remaining &= Remaining - 1;
+                    Advance();
+                }
+
+                return *this;
+            }
+
+
+            inline bool operator!=(const Iterator& rhs) const
+            {
+                return Word != rhs.Word || Remaining != rhs.Remaining;
+            }
+
+        protected:
+            inline void Advance()
+            {
+                while (Remaining == 0 && Word < NumWords)
+                {
+                    if (++Word < NumWords) Remaining = Genes.Present[Word];
+                }
+            }
+
+            const GeneBits& Genes;
+            int Word;
+            std::uint64_t Remaining;
+        };
+
+
+        GeneBits() = default;
+
+
+        explicit GeneBits(const GeneSet& genes)
+        {
+            for (auto&[index, value] : genes) Set(index, value);
+        }
+
+
+        inline Iterator begin() const
+        {
+            return Iterator(*this, 0);
+        }
+
+
+        inline Iterator end() const
+        {
+            return Iterator(*this, NumWords + int(Large.size()));
+        }
+
+
+        inline bool Contains(int index) const
+        {
+            if (index >= DenseCapacity) return FindLarge(index) != Large.end();
+            return (Present[index >> 6] >> (index & 63)) & 1;
+        }
+
+
+        inline int Count() const
+        {
+            auto count = int(Large.size());
+            for (auto word : Present) count += Helpers::PopCount(word);
+            return count;
+        }
+
+
+        /// Returns whether there is a gene at or above an index.
+        inline bool HasFrom(int index) const
+        {
+            if (index >= Capacity) return false;
+            if (!Large.empty() && Large.back().first >= index) return true;
+            if (index >= DenseCapacity) return false;
+
+            if (Present[index >> 6] >> (index & 63)) return true;
+            for (auto w = (index >> 6) + 1; w < NumWords; ++w)
+            {
+                if (Present[w] != 0) return true;
+            }
+
+            return false;
+        }
+
+
+        /// Returns the value of a gene (0 if absent).
+        inline uchar Get(int index) const
+        {
+            if (index >= DenseCapacity)
+            {
+                const auto gene = FindLarge(index);
+                return gene != Large.end() ? gene->second : 0;
+            }
+
+            const auto shift = index & 63;
+            return uchar(((Low[index >> 6] >> shift) & 1) | (((High[index >> 6] >> shift) & 1) << 1));
+        }
+
+
+        inline void Remove(int index)
+        {
+            if (index >= DenseCapacity)
+            {
+                const auto gene = FindLarge(index);
+                if (gene != Large.end()) Large.erase(gene);
+                return;
+            }
+
+            const auto mask = ~(std::uint64_t(1) << (index & 63));
+            Present[index >> 6] &= mask;
+            Low[index >> 6] &= mask;
+            High[index >> 6] &= mask;
+        }
+
+
+        /// Returns the index of the k-th (from 0) gene of the set.
+        inline int Select(int k) const
+        {
+            for (auto w = 0; w < NumWords; ++w)
+            {
+                const auto count = Helpers::PopCount(Present[w]);
+                if (k < count) return 64 * w + Helpers::SelectBit(Present[w], k);
+                k -= count;
+            }
+
+            if (k < int(Large.size())) return Large[k].first;
+            throw std::out_of_range("Too few genes to select from.");
+        }
+
+
+        /// Returns the index of the k-th (from 0) gene not in the set.
+        inline int SelectAbsent(int k) const
+        {
+            const auto absent = GetAbsent();
+            for (auto w = 0; w < NumWords; ++w)
+            {
+                const auto count = Helpers::PopCount(absent[w]);
+                if (k < count) return 64 * w + Helpers::SelectBit(absent[w], k);
+                k -= count;
+            }
+
+            // Past the planes, the absent genes are the indices the large genes skip.
+            auto index = DenseCapacity + k;
+            for (const auto& gene : Large)
+            {
+                if (gene.first > index) break;
+                ++index;
+            }
+
+            if (index >= Capacity) throw std::out_of_range("Too few genes to select from.");
+            return index;
+        }
+
+
+        inline void Set(int index, uchar value)
+        {
+            if (index < 0 || index >= Capacity) throw std::out_of_range("Gene index out of range.");
+
+            if (index >= DenseCapacity)
+            {
+                const auto gene = std::lower_bound(Large.begin(), Large.end(), std::make_pair(index, uchar(0)));
+                if (gene != Large.end() && gene->first == index) gene->second = value;
+                else Large.emplace(gene, index, value);
+                return;
+            }
+
+            const auto bit = std::uint64_t(1) << (index & 63);
+            Present[index >> 6] |= bit;
+            Low[index >> 6] = (value & 1) ? Low[index >> 6] | bit : Low[index >> 6] & ~bit;
+            High[index >> 6] = (value & 2) ? High[index >> 6] | bit : High[index >> 6] & ~bit;
+        }
+
+
+        inline GeneSet ToGeneSet() const
+        {
+            GeneSet genes;
+            for (const auto gene : *this) genes.emplace_hint(genes.end(), gene);
+            return genes;
+        }
+
+
+        /// Returns the genes of the planes that can be added (within capacity, not present).
+        inline Words GetAbsent() const
+        {
+            Words absent;
+            for (auto w = 0; w < NumWords; ++w) absent[w] = ~Present[w];
+            if (DenseCapacity % 64 != 0) absent[NumWords - 1] &= (std::uint64_t(1) << (DenseCapacity % 64)) - 1;
+            return absent;
+        }
+
+
+        inline bool operator==(const GeneBits& rhs) const
+        {
+            return Present == rhs.Present && Low == rhs.Low && High == rhs.High && Large == rhs.Large;
+        }
+
+
+        inline bool operator!=(const GeneBits& rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+
+        /// An arbitrary total order, for use as a key.
+        inline bool operator<(const GeneBits& rhs) const
+        {
+            if (Present != rhs.Present) return Present < rhs.Present;
+            if (Low != rhs.Low) return Low < rhs.Low;
+            if (High != rhs.High) return High < rhs.High;
+            return Large < rhs.Large;
+        }
+
+
+        Words Present = {};
+        Words Low = {};
+        Words High = {};
+        std::vector<std::pair<int, uchar>> Large; // Genes from DenseCapacity on, sorted by index.
+
+    protected:
+        inline std::vector<std::pair<int, uchar>>::const_iterator FindLarge(int index) const
+        {
+            const auto gene = std::lower_bound(Large.begin(), Large.end(), std::make_pair(index, uchar(0)));
+            return gene != Large.end() && gene->first == index ? gene : Large.end();
+        }
+    };
+}
@@ -38,6 +38,18 @@ namespace ABME
         }
 
 
+        /// Reads a genetic code written by Write.
+        inline void Read(MessageReader& message)
+        {
+            BehaviourGenes.Read(message);
+            InteractionGenes.Read(message);
+            ProgrammedLifespan = message.Read<TParam>();
+            ReproductiveAge = message.Read<TParam>();
+            FlipMutationRate = message.Read<TParam>();
+            MetaMutationRate = message.Read<TParam>();
+        }
+
+
         inline void SetFlipMutationParameter(const TParam& param)
         {
             FlipMutationRate = param;
@@ -50,6 +62,18 @@ namespace ABME
         }
 
 
+        /// Writes the genetic code to a message, to be read in another process.
+        inline void Write(MessageWriter& message) const
+        {
+            BehaviourGenes.Write(message);
+            InteractionGenes.Write(message);
+            message.Write(ProgrammedLifespan);
+            message.Write(ReproductiveAge);
+            message.Write(FlipMutationRate);
+            message.Write(MetaMutationRate);
+        }
+
+
         Chromosome<TParam> BehaviourGenes = Chromosome<TParam>(GlobalSettings::BehaviourGenePossibilities); // Behaviour genes can have values in {0, 1}
         Chromosome<TParam> InteractionGenes = Chromosome<TParam>(GlobalSettings::InteractionGenePossibilities); // Interaction genes can have values in {0, ..., 3}
 
@@ -15,6 +15,8 @@ namespace ABME
     bool GlobalSettings::TileDepositsEqualDifference = false;
     bool GlobalSettings::UseSingleStructuralMutationRate = false;
     bool GlobalSettings::MutationRatesEvolve = false;
+    bool GlobalSettings::UseTransitionCache = false;
+    bool GlobalSettings::UseInteractionCache = false;
     double GlobalSettings::BaseMetaMutationRate = 0.0001;
     const double GlobalSettings::WorldUpdateProbability = 0.001;
 
@@ -13,7 +13,7 @@ namespace ABME
         static std::set<int> ShuffleIndices(int numIndices, bool useSimplerGenesFirst);
 
         static std::mt19937 RNG;
-        //static const int NumGenes = 33554432 + 522; // Includes 5x5 genes...
+        //static const int NumGenes = 33554432 + 522; // Includes 5x5 genes (indexed arithmetically, so no tables are needed).
         static const int NumGenes = 522;
         static const bool Randomise = true;
         static const int NumInteractionUpdates = 10;
@@ -22,6 +22,8 @@ namespace ABME
         static const int BehaviourGenePossibilities = 2;
         static const int InteractionGenePossibilities = 4;
         static const int MaxVitality = 256;
+        static const int TransitionCacheSize = 65536;
+        static const int InteractionCacheSize = 65536;
         static const double WorldUpdateProbability;
         static bool ForceEqualChromosomeReproductions;
         static int Seed;
@@ -30,6 +32,8 @@ namespace ABME
         static bool TileDepositsEqualDifference;
         static bool MutationRatesEvolve;
         static bool UseSingleStructuralMutationRate;
+        static bool UseTransitionCache;
+        static bool UseInteractionCache;
         static double BaseMetaMutationRate;
 
     protected:
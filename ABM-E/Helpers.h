@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstdint>
 #include <exception>
 #include <iostream>
 #include <iomanip>
@@ -18,7 +21,7 @@ namespace ABME
 {
     using Gene = std::pair<int, uchar>;
     using GeneSet = std::map<int, uchar>;
-    using PatternMap = std::map<std::string, int>;
+    using BarcodeBits = std::array<std::uint64_t, 4>; // 16x16 cells, 16 bits per row, bit (16 * row + column).
 
     class BadGeneIndexException: std::runtime_error
     {
@@ -53,8 +56,169 @@ namespace ABME
     };
 
 
+    /// A splitmix64 random stream: a single word of state, so it is cheap to
+    /// seed per individual and per step, giving results that do not depend on
+    /// which thread draws the numbers. Usable with the standard distributions.
+    class RandomStream
+    {
+    public:
+        using result_type = std::uint64_t;
+
+        RandomStream(std::uint64_t seed = 0) : State(seed)
+        {
+
+        }
+
+
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+
+        static constexpr result_type max()
+        {
+            return ~result_type(0);
+        }
+
+
+        inline result_type operator()()
+        {
+            return Next();
+        }
+
+
+        inline std::uint64_t Next()
+        {
+            State += 0x9E3779B97F4A7C15ULL;
+            auto z = State;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+
+        /// Returns a uniform number in [0, 1).
+        inline double NextDouble()
+        {
+            return (Next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+
+        std::uint64_t State;
+    };
+
+
     namespace Helpers
     {
+        /// Counts the set bits of a word.
+        inline int PopCount(std::uint64_t word)
+        {
+            return int(std::bitset<64>(word).count());
+        }
+
+
+        /// Returns the position of the lowest set bit of a non-zero word.
+        inline int LowestBit(std::uint64_t word)
+        {
+            return PopCount((word & (~word + 1)) - 1);
+        }
+
+
+        /// Returns the position of the k-th (from 0) lowest set bit of a word,
+        /// which must have more than k set bits.
+        inline int SelectBit(std::uint64_t word, int k)
+        {
+            auto position = 0;
+            for (auto width = 32; width > 0; width /= 2)
+            {
+                const auto low = PopCount(word & ((std::uint64_t(1) << width) - 1));
+                if (k >= low)
+                {
+                    k -= low;
+                    word >>= width;
+                    position += width;
+                }
+            }
+
+            return position;
+        }
+
+
+        /// Counts the set bits of a packed barcode.
+        inline int PopCount(const BarcodeBits& bits)
+        {
+            return PopCount(bits[0]) + PopCount(bits[1]) + PopCount(bits[2]) + PopCount(bits[3]);
+        }
+
+
+        /// Returns whether the cell at the given (row-major) index is set.
+        inline bool TestBit(const BarcodeBits& bits, int index)
+        {
+            return (bits[index >> 6] >> (index & 63)) & 1;
+        }
+
+
+        /// Returns the 16 cells of a barcode row, column i in bit i.
+        inline int GetRow(const BarcodeBits& bits, int row)
+        {
+            return int((bits[row >> 2] >> ((row & 3) * 16)) & 0xFFFF);
+        }
+
+
+        /// Sets or clears the cell at the given (row-major) index.
+        inline void AssignBit(BarcodeBits& bits, int index, bool value)
+        {
+            const auto mask = std::uint64_t(1) << (index & 63);
+            bits[index >> 6] = value ? bits[index >> 6] | mask : bits[index >> 6] & ~mask;
+        }
+
+
+        /// Mixes a word into a running 64-bit hash.
+        inline std::uint64_t HashCombine(std::uint64_t hash, std::uint64_t word)
+        {
+            hash ^= word + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+            hash ^= hash >> 31;
+            hash *= 0xBF58476D1CE4E5B9ULL;
+            return hash ^ (hash >> 29);
+        }
+
+
+        /// Hashes a packed barcode, seeded with another hash (e.g. a genome fingerprint).
+        inline std::uint64_t Hash(const BarcodeBits& bits, std::uint64_t seed = 0)
+        {
+            for (auto word : bits) seed = HashCombine(seed, word);
+            return seed;
+        }
+
+
+        /// Reverses the order of the lowest numBits bits of a value.
+        inline int ReverseBits(int value, int numBits)
+        {
+            int reversed = 0;
+            for (auto i = 0; i < numBits; ++i)
+            {
+                reversed |= ((value >> i) & 1) << (numBits - 1 - i);
+            }
+
+            return reversed;
+        }
+
+
+        /// Transposes a square window of width x width cells packed row by row
+        /// into one packed column by column, or the other way around.
+        inline int TransposeWindow(int code, int width)
+        {
+            int transposed = 0;
+            for (auto k = 0; k < width * width; ++k)
+            {
+                transposed |= ((code >> k) & 1) << (width * (k % width) + k / width);
+            }
+
+            return transposed;
+        }
+
+
         /// Swaps pointers.
         inline void Swap(void*& first, void*& second)
         {
@@ -64,6 +228,35 @@ namespace ABME
         }
 
 
+        /// Returns the index of the first gene with patterns of numCells cells.
+        inline int GetGeneOffset(int numCells)
+        {
+            switch (numCells)
+            {
+            case 1:
+                return 0;
+            case 3:
+                return 2;
+            case 9:
+                return 10;
+            case 25:
+                return 522;
+            default:
+                std::stringstream warning;
+                warning << "No genes have patterns of " << numCells << " cells.";
+                throw BadGeneIndexException(warning.str());
+            }
+        }
+
+
+        /// Returns the index of the gene for a pattern of numCells cells, packed so
+        /// that bit k holds cell k (the inverse of GetParentPattern).
+        inline int GetGeneIndex(int code, int numCells)
+        {
+            return GetGeneOffset(numCells) + ReverseBits(code, numCells);
+        }
+
+
         /// Returns a bit pattern as a vector of chars, with 0 being off, and 1 on.
         inline std::string GetParentPattern(int geneIndex)
         {
@@ -109,39 +302,6 @@ namespace ABME
         }
 
 
-        inline PatternMap GenerateShortPatternMap()
-        {
-            std::cout << "Generating short patterns up to 3x3. ";
-
-            PatternMap map;
-            for (int i = 0; i < 522; ++i)
-            {
-                map[GetParentPattern(i)] = i;
-            }
-
-            std::cout << "Finished.\n";
-
-            return map;
-        }
-
-        
-        inline PatternMap GenerateLongPatternMap()
-        {
-            std::cout << "Generating 5x5 patterns. This may take a while... ";
-
-            PatternMap map;
-#pragma omp parallel for
-            for (int i = 522; i < GlobalSettings::NumGenes; ++i)
-            {
-                map[GetParentPattern(i)] = i;
-            }
-
-            std::cout << "Finished.\n";
-
-            return map;
-        }
-
-
         inline std::string ConvertMatToString(const cv::Mat& region)
         {
             std::string representation(region.cols * region.rows, 0);
@@ -207,17 +367,6 @@ namespace ABME
         }
 
 
-        /// Converts a chromosome into two vectors.
-        inline void ConvertChromosomeToVectors(GeneSet& chromosome, std::vector<int>& geneIndices, std::vector<uchar>& geneValues)
-        {
-            for (auto&[index, value] : chromosome)
-            {
-                geneIndices.push_back(index);
-                geneValues.push_back(value);
-            }
-        }
-
-
         /// Counts chromosomes.
         inline std::map<GeneSet, int> ChromosomeCounts(std::vector<GeneSet>& chromosomes)
         {
@@ -323,28 +472,6 @@ namespace ABME
         }
 
 
-        inline bool PointInsideRects(const cv::Point& point, std::vector<cv::Rect>& rects)
-        {
-            for (auto& rect : rects)
-            {
-                if (point.inside(rect)) return true;
-            }
-
-            return false;
-        }
-
-
-        inline int PointInRegionIndex(const cv::Point& point, std::vector<cv::Rect>& rects)
-        {
-            for (int i = 0; i < rects.size(); ++i)
-            {
-                if (point.inside(rects[i])) return i;
-            }
-
-            return -1;
-        }
-
-
         inline std::string CurrentTimeString()
         {
             auto t = std::time(nullptr);
@@ -357,8 +484,8 @@ namespace ABME
         }
 
 
-        template <typename T>
-        inline T Crossover(T& first, T& second, std::uniform_real_distribution<>& dist)
+        template <typename T, typename TRandom = std::mt19937>
+        inline T Crossover(T& first, T& second, std::uniform_real_distribution<>& dist, TRandom& rng = GlobalSettings::RNG)
         {
             T t = 0;
             for (int i = 0; i < 8 * sizeof(T); ++i)
@@ -366,7 +493,7 @@ namespace ABME
                 bool firstBit = (first & 1UL << i) == (1UL << i);
                 bool secondBit = (second & 1UL << i) == (1UL << i);
 
-                bool choice = dist(GlobalSettings::RNG) < 0.5 ? firstBit : secondBit;
+                bool choice = dist(rng) < 0.5 ? firstBit : secondBit;
                 t = choice ? t | (1UL << i) : t & ~(1UL << i);
             }
 
@@ -374,12 +501,12 @@ namespace ABME
         }
 
 
-        template <typename T>
-        inline T BitFlip(T& operand, std::uniform_real_distribution<>& dist, double flipProbability)
+        template <typename T, typename TRandom = std::mt19937>
+        inline T BitFlip(T& operand, std::uniform_real_distribution<>& dist, double flipProbability, TRandom& rng = GlobalSettings::RNG)
         {
             for (int i = 0; i < 8 * sizeof(T); ++i)
             {
-                if (dist(GlobalSettings::RNG) < flipProbability)
+                if (dist(rng) < flipProbability)
                 {
                     operand ^= (1UL << i);
                 }
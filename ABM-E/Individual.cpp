@@ -1,7 +1,6 @@
 #include "Individual.h"
 
 #include <opencv2/highgui.hpp>
-#include <omp.h>
 #include "Barcode.h"
 #include "GlobalSettings.h"
 
@@ -9,13 +8,12 @@ namespace ABME
 {
     using namespace cv;
 
-    PatternMap Individual::ShortGenePatternMap = Helpers::GenerateShortPatternMap();
-    PatternMap Individual::LongGenePatternMap = Helpers::GenerateLongPatternMap();
 
-
-    Individual::Individual(Environment& environment, GeneticCode<ushort> geneticCode) : ItsEnvironment(environment), ItsGeneticCode(geneticCode)
+    Individual::Individual(Environment& environment, GeneticCode<ushort> geneticCode) : ItsEnvironment(environment), ItsGeneticCode(geneticCode), CurrentBarcode(ItsGeneticCode.BehaviourGenes.Genes, ItsGeneticCode.BehaviourGenes.Rules)
     {
-        CurrentBarcode = std::make_unique<Barcode>(ItsGeneticCode.BehaviourGenes.Genes, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize);
+        // Compile the genes into rule tables once, at birth.
+        ItsGeneticCode.BehaviourGenes.Compile(true);
+        ItsGeneticCode.InteractionGenes.Compile();
     }
 
 
@@ -27,7 +25,7 @@ namespace ABME
 
     void Individual::DrawBarcode(std::string& windowName)
     {
-        CurrentBarcode->Draw(windowName);
+        CurrentBarcode.Draw(windowName);
     }
 
 
@@ -37,76 +35,76 @@ namespace ABME
     }
 
 
-    Individual* Individual::Clone(bool ignoreBalance) const
+    /// Creates a copy of the genome and barcode in the environment's pool. The
+    /// rest of the state is copied when the copy is added to a population.
+    IndividualHandle Individual::Clone(bool ignoreBalance) const
     {
-        auto* individual = new Individual(ItsEnvironment, ItsGeneticCode);
-        individual->Age = Age;
-        individual->X = X;
-        individual->Y = Y;
-        individual->Vitality = Vitality;
+        const auto handle = ItsEnvironment.GetPool().Create(ItsEnvironment, ItsGeneticCode);
+        auto* individual = ItsEnvironment.GetPool().Get(handle);
 
         // Copy barcode pattern.
-        individual->CurrentBarcode->SetStringRepresentation(CurrentBarcode->GetStringRepresentation());
+        individual->CurrentBarcode.SetBits(CurrentBarcode.GetBits());
 
-        return individual;
+        return handle;
     }
 
 
     /// Detects whether any of the points of this individual
     /// overlaps with any of the unallowed regions.
-    bool Individual::DetectCollision(const cv::Rect& thisRect, std::vector<cv::Rect>& regions)
+    bool Individual::DetectCollision(const cv::Rect& thisRect, const RegionMap& regions)
     {
-        const auto area = thisRect.area();
-        auto runningArea = 0;
-        for (auto& r : regions)
-        {
-            runningArea += (thisRect & r).area();
-            if (runningArea == area) return false;
-        }
-
-        return true;
+        return !regions.Covers(thisRect);
     }
 
 
-    const std::string& Individual::GetBarcodeString() const
+    const BarcodeBits& Individual::GetBarcodeBits() const
     {
-        return CurrentBarcode->GetStringRepresentation();
+        return CurrentBarcode.GetBits();
     }
 
 
     void Individual::Kill()
     {
-        Alive = false;
+        ItsPopulation->Alive[Row] = 0;
     }
 
 
-    void Individual::Update(Mat& interactableEnvironment, Environment::ColocationMapType& colocations)
+    /// Updates the individual by one step.
+    /// Only touches the individual and the world under it, so individuals
+    /// whose world patches do not overlap can be updated concurrently.
+    void Individual::Update(const PackedMap& interactableEnvironment)
     {
+        auto& population = *ItsPopulation;
+        auto& x = population.X[Row];
+        auto& y = population.Y[Row];
+        auto& age = population.Age[Row];
+        auto& vitality = population.Vitality[Row];
+
         // Integrate environmental input.
-        auto interactionRegion = interactableEnvironment(Rect(X, Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize));
-        CurrentBarcode->Input(interactionRegion);
+        CurrentBarcode.Input(interactableEnvironment, x, y);
 
         // Update barcode once.
-        CurrentBarcode->Update(true, ItsGeneticCode.BehaviourGenes.HasLargePatterns);
+        CurrentBarcode.Update(true, ItsGeneticCode.BehaviourGenes.HasLargePatterns);
+        population.Barcodes[Row] = CurrentBarcode.GetBits();
 
         // Update world.
-        Vitality += (ProcessWorld() > 0 ? 1 : -1);
+        vitality += (ProcessWorld() > 0 ? 1 : -1);
 
         // Calculate movement and consumption.
         Vec2i movement; int cellsActive = 0;
-        CurrentBarcode->ComputeMetrics(movement, cellsActive);
+        CurrentBarcode.ComputeMetrics(movement, cellsActive);
 
         // Update live status.
         // An individual dies if it has no food or all or no cell is active.
-        if (Vitality <= 0 || Vitality >= GlobalSettings::MaxVitality || Age >= ItsGeneticCode.ProgrammedLifespan)
+        if (vitality <= 0 || vitality >= GlobalSettings::MaxVitality || age >= ItsGeneticCode.ProgrammedLifespan)
         {
             Kill();
             return;
         }
 
         // Compute movement and collisions.
-        int newX = X + GlobalSettings::DistanceStep * (movement[0] / GlobalSettings::DistanceStep);
-        int newY = Y + GlobalSettings::DistanceStep * (movement[1] / GlobalSettings::DistanceStep);
+        int newX = x + GlobalSettings::DistanceStep * (movement[0] / GlobalSettings::DistanceStep);
+        int newY = y + GlobalSettings::DistanceStep * (movement[1] / GlobalSettings::DistanceStep);
         ItsEnvironment.ClampPositions(newX, newY);
 
         const auto greaterMovement = std::max(std::abs(movement[0]), std::abs(movement[1]));
@@ -115,27 +113,24 @@ namespace ABME
             for (auto i = greaterMovement; i > 0;)
             {
                 auto thisRect = cv::Rect(newX, newY, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize);
-                if (!DetectCollision(thisRect, ItsEnvironment.GetRegions())) break;
+                if (!DetectCollision(thisRect, ItsEnvironment.GetRegionMap())) break;
 
                 --i;
-                newX = X + GlobalSettings::DistanceStep * (int(i * (float(movement[0]) / greaterMovement) / GlobalSettings::DistanceStep));
-                newY = Y + GlobalSettings::DistanceStep * (int(i * (float(movement[1]) / greaterMovement) / GlobalSettings::DistanceStep));
+                newX = x + GlobalSettings::DistanceStep * (int(i * (float(movement[0]) / greaterMovement) / GlobalSettings::DistanceStep));
+                newY = y + GlobalSettings::DistanceStep * (int(i * (float(movement[1]) / greaterMovement) / GlobalSettings::DistanceStep));
                 ItsEnvironment.ClampPositions(newX, newY);
             }
         }
         
         // Perform movement.
-        X = newX;
-        Y = newY;
+        x = newX;
+        y = newY;
 
         // Only update food if we couldn't extract or deposit new tiles.
         LastCellsActive = cellsActive;
 
-        // Add position to colocations.
-        colocations.insert(std::pair(Vec2i(X, Y), this));
-
         // Update individual parameters.
-        Age += 1;
+        age += 1;
     }
 
 
@@ -145,13 +140,20 @@ namespace ABME
 
         // Convert world at this location to a string.
         auto& wholeMap = ItsEnvironment.GetMap();
-        std::string worldString = Helpers::ConvertMatToString(wholeMap(Rect(X, Y, GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize)));
+        const auto x = GetX();
+        const auto y = GetY();
+        std::string worldString(GlobalSettings::BarcodeSize * GlobalSettings::BarcodeSize, 0);
+        for (auto j = 0; j < GlobalSettings::BarcodeSize; ++j)
+        {
+            const auto row = wholeMap.GetRow(x, y + j);
+            for (auto i = 0; i < GlobalSettings::BarcodeSize; ++i) worldString[j * GlobalSettings::BarcodeSize + i] = (row >> i) & 1;
+        }
 
         // Find pattern matches in this region, and update the map with some small probability.
         auto oldWorldString = worldString;
 
         // Do the 1D genes first.
-        for (auto&[key, val] : ItsGeneticCode.InteractionGenes.Genes)
+        for (auto [key, val] : ItsGeneticCode.InteractionGenes.Genes)
         {
             if (key >= 10) break;
             std::string pattern = Helpers::GetParentPattern(key);
@@ -164,11 +166,10 @@ namespace ABME
         // Do the 5x5 2D genes next...
         if (ItsGeneticCode.InteractionGenes.HasLargePatterns) vitalityUpdate += UpdateWorld2D(oldWorldString, 5, worldString);
 
-        // Update the world using the new string.
-        for (int i = 0; i < worldString.size(); ++i)
-        {
-            wholeMap.at<uchar>(Y + i / GlobalSettings::BarcodeSize, X + i % GlobalSettings::BarcodeSize) = worldString[i] == 1 ? 255 : 0;
-        }
+        // Update the world using the new string, if anything changed.
+        if (worldString == oldWorldString) return vitalityUpdate;
+
+        ItsEnvironment.WriteTiles(x, y, worldString, TileSourceIndividuals);
 
         return vitalityUpdate;
     }
@@ -181,50 +182,35 @@ namespace ABME
         InterpretInteractionGeneValue(geneValue, increment, replacement);
         
         int count = 0;
-        std::uniform_real_distribution<> dist(0.0, 1.0);
-
-#pragma omp parallel
+        for (int j = 0; j < GlobalSettings::BarcodeSize; ++j)
         {
-            static thread_local int threadID = omp_get_thread_num();
-            static thread_local std::mt19937 localRNG;
-            static thread_local bool initialised = false;
-            if (!initialised)
+            std::string subString = oldWorldString.substr(j * GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize);
+            std::vector<size_t> positions;
+            positions.reserve(GlobalSettings::BarcodeSize);
+
+            size_t pos = subString.find(pattern, 0);
+            while (pos != std::string::npos)
             {
-                localRNG.seed(GlobalSettings::Seed + threadID);
-                initialised = true;
+                count += increment;
+                positions.push_back(pos);
+                pos = subString.find(pattern, pos + 1);
             }
 
-#pragma omp for reduction(+:count)
-            for (int j = 0; j < GlobalSettings::BarcodeSize; ++j)
+            // Replace in the new pattern.
+            if (pattern.size() == 1)
             {
-                std::string subString = oldWorldString.substr(j * GlobalSettings::BarcodeSize, GlobalSettings::BarcodeSize);
-                std::vector<size_t> positions;
-                positions.reserve(GlobalSettings::BarcodeSize);
-
-                size_t pos = subString.find(pattern, 0);
-                while (pos != std::string::npos)
-                {
-                    count += increment;
-                    positions.push_back(pos);
-                    pos = subString.find(pattern, pos + 1);
-                }
-
-                // Replace in the new pattern.
-                if (pattern.size() == 1)
+                for (auto& pos : positions)
                 {
-                    for (auto& pos : positions)
-                    {
-                        auto& tile = newWorldString[GlobalSettings::BarcodeSize * j + pos];
-                        tile = (dist(localRNG) < GlobalSettings::WorldUpdateProbability) ? replacement : tile;
-                    }
+                    auto& tile = newWorldString[GlobalSettings::BarcodeSize * j + pos];
+                    tile = (WorldRNG.NextDouble() < GlobalSettings::WorldUpdateProbability) ? replacement : tile;
                 }
-                else if (pattern.size() == 3)
+            }
+            else if (pattern.size() == 3)
+            {
+                for (auto& pos : positions)
                 {
-                    for (auto& pos : positions)
-                    {
-                        auto& tile = newWorldString[GlobalSettings::BarcodeSize * j + pos + 1];
-                        tile = dist(localRNG) < GlobalSettings::WorldUpdateProbability ? replacement : tile;
-                    }
+                    auto& tile = newWorldString[GlobalSettings::BarcodeSize * j + pos + 1];
+                    tile = WorldRNG.NextDouble() < GlobalSettings::WorldUpdateProbability ? replacement : tile;
                 }
             }
         }
@@ -235,56 +221,35 @@ namespace ABME
 
     int Individual::UpdateWorld2D(std::string& oldWorldString, int patternWidth, std::string& newWorldString)
     {
-        static auto randomDevice = std::random_device();
-        static thread_local std::mt19937 localRNG;
-        localRNG.seed(GlobalSettings::Randomise ? randomDevice() : GlobalSettings::Seed);
-
-        auto& map = patternWidth <= 3 ? ShortGenePatternMap : LongGenePatternMap;
-        std::uniform_real_distribution<> dist(0.0, 1.0);
+        auto& rules = ItsGeneticCode.InteractionGenes.Rules;
 
         const int edgeLimit = patternWidth - 1;
         const int replaceOffset = (patternWidth - 1) / 2;
         int count = 0;
 
-#pragma omp parallel
+        for (int j = 0; j < GlobalSettings::BarcodeSize - edgeLimit; ++j)
         {
-            static thread_local int threadID = omp_get_thread_num();
-            static thread_local std::mt19937 localRNG;
-            static thread_local bool initialised = false;
-            if (!initialised)
+            for (int i = 0; i < GlobalSettings::BarcodeSize - edgeLimit; ++i)
             {
-                localRNG.seed(GlobalSettings::Seed + threadID);
-                initialised = true;
-            }
-
-#pragma omp for reduction(+:count)
-            for (int j = 0; j < GlobalSettings::BarcodeSize - edgeLimit; ++j)
-            {
-                for (int i = 0; i < GlobalSettings::BarcodeSize - edgeLimit; ++i)
+                // Find the gene for the pattern at this position of the barcode, if we have it.
+                auto code = 0;
+                for (auto k = 0; k < patternWidth * patternWidth; ++k)
                 {
-                    // Get the pattern at this position of the barcode.
-                    std::string subString;
-                    for (auto k = j; k < j + patternWidth; ++k)
-                    {
-                        subString += oldWorldString.substr(k * GlobalSettings::BarcodeSize + i, patternWidth);
-                    }
-
-                    // Find which gene this would require.
-                    auto& geneIndex = map[subString];
-
-                    // Do we have this gene?
-                    if (ItsGeneticCode.InteractionGenes.Genes.count(geneIndex) == 0) continue;
-
-                    // Otherwise get the gene and increment the vitality update by the gene value.
-                    int increment;
-                    uchar replacement;
-                    InterpretInteractionGeneValue(ItsGeneticCode.InteractionGenes.Genes[geneIndex], increment, replacement);
-                    count += increment;
-
-                    // Replace at the right position.
-                    auto& tile = newWorldString[GlobalSettings::BarcodeSize * (j + replaceOffset) + i + replaceOffset];
-                    tile = dist(localRNG) < GlobalSettings::WorldUpdateProbability ? replacement : tile;
+                    code |= oldWorldString[(j + k / patternWidth) * GlobalSettings::BarcodeSize + i + k % patternWidth] << k;
                 }
+
+                auto geneValue = patternWidth == 3 ? rules.Rules9[code] : rules.Rules25.Find(Helpers::TransposeWindow(code, 5));
+                if (geneValue == RuleTable::NoGene) continue;
+
+                // Increment the vitality update by the gene value.
+                int increment;
+                uchar replacement;
+                InterpretInteractionGeneValue(geneValue, increment, replacement);
+                count += increment;
+
+                // Replace at the right position.
+                auto& tile = newWorldString[GlobalSettings::BarcodeSize * (j + replaceOffset) + i + replaceOffset];
+                tile = WorldRNG.NextDouble() < GlobalSettings::WorldUpdateProbability ? replacement : tile;
             }
         }
 
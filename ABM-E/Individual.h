@@ -1,8 +1,12 @@
 #pragma once
 
+#include "Barcode.h"
 #include "Environment.h"
 #include "GeneticCode.h"
 #include "Helpers.h"
+#include "IndividualPool.h"
+#include "Population.h"
+#include "RegionMap.h"
 
 namespace cv
 {
@@ -12,8 +16,6 @@ namespace cv
 
 namespace ABME
 {
-    class Barcode;
-
     class Individual
     {
     public:
@@ -22,38 +24,71 @@ namespace ABME
 
         bool AddDropTile(int numToTake);
         bool BeBorn();
-        Individual* Clone(bool ignoreBalance) const;
+        IndividualHandle Clone(bool ignoreBalance) const;
         void DrawBarcode(std::string& windowName);
-        const std::string& GetBarcodeString() const;
+        const BarcodeBits& GetBarcodeBits() const;
         void Kill();
-        void Update(cv::Mat& interactableEnvironment, Environment::ColocationMapType& colocations);
+        void Update(const PackedMap& interactableEnvironment);
+
+        inline int GetAge() const
+        {
+            return ItsPopulation->Age[Row];
+        }
+
+
+        inline int GetVitality() const
+        {
+            return ItsPopulation->Vitality[Row];
+        }
+
+
+        inline int GetX() const
+        {
+            return ItsPopulation->X[Row];
+        }
+
+
+        inline int GetY() const
+        {
+            return ItsPopulation->Y[Row];
+        }
+
 
         inline bool IsAlive() const
         {
-            return Alive;
+            return ItsPopulation->Alive[Row] != 0;
+        }
+
+
+        inline void SetPosition(int x, int y)
+        {
+            ItsPopulation->X[Row] = x;
+            ItsPopulation->Y[Row] = y;
         }
 
-        static bool DetectCollision(const cv::Rect& thisRect, std::vector<cv::Rect>& regions);
+
+        inline void SetVitality(int vitality)
+        {
+            ItsPopulation->Vitality[Row] = vitality;
+        }
+
+        static bool DetectCollision(const cv::Rect& thisRect, const RegionMap& regions);
 
         Environment& ItsEnvironment;
         GeneticCode<ushort> ItsGeneticCode;
-        std::unique_ptr<Barcode> CurrentBarcode;
+        Barcode CurrentBarcode; // Refers to the behaviour genes above.
 
-        int Age = 0;
-        int X = -1;
-        int Y = -1;
-        int LastCellsActive = 0;
-        int Vitality = GlobalSettings::MaxVitality / 2;
+        // The rest of the state is in the population's row (set when added to one).
+        Population* ItsPopulation = nullptr;
+        int Row = -1;
 
-        static PatternMap ShortGenePatternMap;
-        static PatternMap LongGenePatternMap;
+        int LastCellsActive = 0;
+        RandomStream WorldRNG; // Reseeded by the environment every step.
 
     protected:
         int ProcessWorld();
         int UpdateWorld1D(std::string& pattern, uchar& replacement, std::string& oldWorldString, std::string& update);
         int UpdateWorld2D(std::string& oldBarcode, int patternWidth, std::string& newWorldString);
         static void InterpretInteractionGeneValue(uchar& val, int& vitalityUpdate, uchar& replacement);
-
-        bool Alive = true;
     };
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "IndividualPool.h"
+
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include "Individual.h"
+
+namespace ABME
+{
+    struct IndividualPool::Slot
+    {
+        alignas(Individual) unsigned char Storage[sizeof(Individual)];
+        std::uint32_t Generation = 1;
+        bool Occupied = false;
+
+        inline Individual* Get()
+        {
+            return std::launder(reinterpret_cast<Individual*>(Storage));
+        }
+    };
+
+
+    IndividualPool::IndividualPool() : Slabs(new std::unique_ptr<Slot[]>[MaxSlabs])
+    {
+
+    }
+
+
+    IndividualPool::~IndividualPool()
+    {
+        for (std::uint32_t index = 0; index < NumSlots; ++index)
+        {
+            auto& slot = Slabs[index / SlabSize][index % SlabSize];
+            if (slot.Occupied) slot.Get()->~Individual();
+        }
+    }
+
+
+    /// Constructs an individual in a free slot, adding a slab if none is free.
+    IndividualHandle IndividualPool::Create(Environment& environment, const GeneticCode<ushort>& geneticCode)
+    {
+        std::uint32_t index;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            if (!FreeSlots.empty())
+            {
+                index = FreeSlots.back();
+                FreeSlots.pop_back();
+                ++Reuses;
+            }
+            else
+            {
+                if (NumSlots == std::uint32_t(SlabSize) * MaxSlabs) throw std::runtime_error("Individual pool exhausted.");
+                if (NumSlots % SlabSize == 0) Slabs[NumSlots / SlabSize].reset(new Slot[SlabSize]);
+                index = NumSlots++;
+            }
+        }
+
+        // The slot is reserved, so it can be filled outside the lock.
+        auto& slot = Slabs[index / SlabSize][index % SlabSize];
+        new (slot.Storage) Individual(environment, geneticCode);
+        slot.Occupied = true;
+
+        ++Allocations;
+        ++NumLive;
+
+        return { index, slot.Generation };
+    }
+
+
+    /// Returns the individual a handle refers to, or nullptr if it was released.
+    Individual* IndividualPool::Get(IndividualHandle handle) const
+    {
+        if (handle.Index >= NumSlots) return nullptr;
+
+        auto& slot = Slabs[handle.Index / SlabSize][handle.Index % SlabSize];
+        return slot.Occupied && slot.Generation == handle.Generation ? slot.Get() : nullptr;
+    }
+
+
+    std::string IndividualPool::GetStatistics() const
+    {
+        std::stringstream statistics;
+        statistics << Size() << " live in " << (NumSlots + SlabSize - 1) / SlabSize << " slabs (" << Allocations << " allocations, " << Releases << " releases, " << Reuses << " from the free list)";
+
+        return statistics.str();
+    }
+
+
+    /// Destroys an individual and recycles its slot. Stale handles are ignored.
+    void IndividualPool::Release(IndividualHandle handle)
+    {
+        auto* individual = Get(handle);
+        if (individual == nullptr) return;
+
+        auto& slot = Slabs[handle.Index / SlabSize][handle.Index % SlabSize];
+        individual->~Individual();
+        slot.Occupied = false;
+        if (++slot.Generation == 0) slot.Generation = 1;
+
+        ++Releases;
+        --NumLive;
+
+        std::lock_guard<std::mutex> lock(Mutex);
+        FreeSlots.push_back(handle.Index);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    class Environment;
+    class Individual;
+    template <typename T> class GeneticCode;
+
+    /// Refers to an individual in an IndividualPool. A slot's generation
+    /// changes when it is released, so handles kept past an individual's
+    /// removal resolve to nothing instead of to whoever reuses the slot.
+    struct IndividualHandle
+    {
+        std::uint32_t Index = 0;
+        std::uint32_t Generation = 0; // Slots start at generation 1, so default handles are never valid.
+
+        inline bool IsValid() const
+        {
+            return Generation != 0;
+        }
+
+
+        inline bool operator==(const IndividualHandle& rhs) const
+        {
+            return Index == rhs.Index && Generation == rhs.Generation;
+        }
+    };
+
+
+    /// Slab storage for individuals (each with its barcode inline), so a birth
+    /// takes a recycled slot rather than separate heap allocations. Released
+    /// slots go on a free list; slabs are never moved or freed while the pool
+    /// lives, so individuals keep their address. Creation and release may be
+    /// called from many threads.
+    class IndividualPool
+    {
+    public:
+        IndividualPool();
+        ~IndividualPool();
+
+        IndividualPool(const IndividualPool&) = delete;
+        IndividualPool& operator=(const IndividualPool&) = delete;
+
+        IndividualHandle Create(Environment& environment, const GeneticCode<ushort>& geneticCode);
+        Individual* Get(IndividualHandle handle) const;
+        std::string GetStatistics() const;
+        void Release(IndividualHandle handle);
+
+        /// Returns the number of live individuals.
+        inline size_t Size() const
+        {
+            return NumLive.load(std::memory_order_relaxed);
+        }
+
+
+        std::atomic<std::uint64_t> Allocations{ 0 };
+        std::atomic<std::uint64_t> Releases{ 0 };
+        std::atomic<std::uint64_t> Reuses{ 0 }; // Allocations served from the free list.
+
+        static const int SlabSize = 1024;
+        static const int MaxSlabs = 4096;
+
+    protected:
+        struct Slot;
+
+        std::unique_ptr<std::unique_ptr<Slot[]>[]> Slabs;
+        std::atomic<std::uint32_t> NumSlots{ 0 }; // Slots handed out at least once.
+        std::vector<std::uint32_t> FreeSlots;
+        std::atomic<size_t> NumLive{ 0 };
+        std::mutex Mutex;
+    };
+}
\ No newline at end of file
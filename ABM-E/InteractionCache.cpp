@@ -0,0 +1,42 @@
+#include "InteractionCache.h"
+
+#include "GlobalSettings.h"
+
+namespace ABME
+{
+    /// Looks up how an interaction ends, counting hits and misses.
+    bool InteractionCache::Find(const RuleTable& firstRules, const BarcodeBits& first, const RuleTable& secondRules, const BarcodeBits& second, InteractionOutcome& outcome)
+    {
+        if (IsSwapped(firstRules, first, secondRules, second))
+        {
+            InteractionOutcome swapped;
+            if (!Find(secondRules, second, firstRules, first, swapped)) return false;
+
+            outcome = Swap(swapped);
+            return true;
+        }
+
+        return SetAssociativeCache::Find({ firstRules.Fingerprint, firstRules.Checksum, secondRules.Fingerprint, secondRules.Checksum, first, second }, outcome);
+    }
+
+
+    /// Stores how an interaction ends.
+    void InteractionCache::Insert(const RuleTable& firstRules, const BarcodeBits& first, const RuleTable& secondRules, const BarcodeBits& second, const InteractionOutcome& outcome)
+    {
+        if (IsSwapped(firstRules, first, secondRules, second))
+        {
+            Insert(secondRules, second, firstRules, first, Swap(outcome));
+            return;
+        }
+
+        SetAssociativeCache::Insert({ firstRules.Fingerprint, firstRules.Checksum, secondRules.Fingerprint, secondRules.Checksum, first, second }, outcome);
+    }
+
+
+    /// Returns the shared cache, created on first use (which may be on any thread).
+    InteractionCache& InteractionCache::Instance()
+    {
+        static InteractionCache instance(GlobalSettings::InteractionCacheSize);
+        return instance;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Helpers.h"
+#include "Interactor.h"
+#include "RuleTable.h"
+#include "SetAssociativeCache.h"
+
+namespace ABME
+{
+    /// An interaction's key: both genomes' fingerprints and checksums, and both
+    /// starting barcodes.
+    struct InteractionKey
+    {
+        std::uint64_t FirstGenome = 0;
+        std::uint64_t FirstChecksum = 0;
+        std::uint64_t SecondGenome = 0;
+        std::uint64_t SecondChecksum = 0;
+        BarcodeBits First = {};
+        BarcodeBits Second = {};
+
+        inline bool operator==(const InteractionKey& other) const
+        {
+            return FirstGenome == other.FirstGenome && FirstChecksum == other.FirstChecksum && SecondGenome == other.SecondGenome && SecondChecksum == other.SecondChecksum
+                && First == other.First && Second == other.Second;
+        }
+
+
+        inline std::uint64_t Hash() const
+        {
+            return Helpers::Hash(Second, Helpers::Hash(First, Helpers::HashCombine(FirstGenome, SecondGenome)));
+        }
+    };
+
+
+    /// Memoises interactions: maps the behaviour genomes and starting barcodes
+    /// of a pair to how their interaction ends (which only depends on those).
+    /// Pairs are stored in a canonical order, so a pair and its swap share an
+    /// entry.
+    class InteractionCache : public SetAssociativeCache<InteractionKey, InteractionOutcome>
+    {
+    public:
+        InteractionCache(int numEntries) : SetAssociativeCache(numEntries)
+        {
+        }
+
+        bool Find(const RuleTable& firstRules, const BarcodeBits& first, const RuleTable& secondRules, const BarcodeBits& second, InteractionOutcome& outcome);
+        void Insert(const RuleTable& firstRules, const BarcodeBits& first, const RuleTable& secondRules, const BarcodeBits& second, const InteractionOutcome& outcome);
+
+        static InteractionCache& Instance();
+
+    protected:
+        /// Returns whether the pair is the wrong way round for storing.
+        static inline bool IsSwapped(const RuleTable& firstRules, const BarcodeBits& first, const RuleTable& secondRules, const BarcodeBits& second)
+        {
+            if (firstRules.Fingerprint != secondRules.Fingerprint) return firstRules.Fingerprint > secondRules.Fingerprint;
+            if (firstRules.Checksum != secondRules.Checksum) return firstRules.Checksum > secondRules.Checksum;
+            return first > second;
+        }
+
+
+        static inline InteractionOutcome Swap(const InteractionOutcome& outcome)
+        {
+            return { outcome.SecondDies, outcome.FirstDies };
+        }
+    };
+}
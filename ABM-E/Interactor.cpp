@@ -3,18 +3,19 @@
 #include "Barcode.h"
 #include "Individual.h"
 #include "GeneticCode.h"
+#include "InteractionCache.h"
 
 namespace ABME
 {
     /// This interacts each subsequent pair, in a non-overlapping way.
     /// Thus, if there are an odd number, one is uninteracted with.
-    std::vector<Individual*> Interactor::Interact(std::vector<Individual*> colocations)
+    std::vector<Offspring> Interactor::Interact(const std::vector<Individual*>& colocations, RandomStream& rng)
     {
-        std::vector<Individual*> newIndividuals;
-        for (auto i = 0; i < colocations.size() - 1; i += 2)
+        std::vector<Offspring> newIndividuals;
+        for (size_t i = 0; i + 1 < colocations.size(); i += 2)
         {
-            auto newIndividual = Interact(*colocations[i], *colocations[i + 1]);
-            if (newIndividual != nullptr)
+            auto newIndividual = Interact(*colocations[i], *colocations[i + 1], rng);
+            if (newIndividual.Handle.IsValid())
             {
                 newIndividuals.push_back(newIndividual);
             }
@@ -26,74 +27,110 @@ namespace ABME
 
     /// This decides the outcome of an interaction:
     /// Either both die, or one dies, or both live and produce an offspring.
-    Individual* Interactor::Interact(Individual& first, Individual& second)
+    Offspring Interactor::Interact(Individual& first, Individual& second, RandomStream& rng)
     {
-        // Clone barcodes.
-        auto firstClone = *first.CurrentBarcode;
-        auto secondClone = *second.CurrentBarcode;
-        auto firstCloneNext = *first.CurrentBarcode;
-        auto secondCloneNext = *second.CurrentBarcode;
-        auto firstCount = 0;
-        auto secondCount = 0;
-        auto firstHasLargePatterns = first.ItsGeneticCode.BehaviourGenes.HasLargePatterns;
-        auto secondHasLargePatterns = second.ItsGeneticCode.BehaviourGenes.HasLargePatterns;
-
-        for (auto i = 0; i < GlobalSettings::NumInteractionUpdates; ++i)
+        auto& firstGenes = first.ItsGeneticCode.BehaviourGenes;
+        auto& secondGenes = second.ItsGeneticCode.BehaviourGenes;
+        auto& firstBits = first.CurrentBarcode.GetBits();
+        auto& secondBits = second.CurrentBarcode.GetBits();
+
+        // The outcome only depends on the genomes and barcodes, so recurring pairings are looked up.
+        InteractionOutcome outcome;
+        if (!GlobalSettings::UseInteractionCache || !InteractionCache::Instance().Find(firstGenes.Rules, firstBits, secondGenes.Rules, secondBits, outcome))
         {
-            // Keep the complement of the intersection.
-            firstCloneNext.Subtract(secondClone);
-            secondCloneNext.Subtract(firstClone);
-
-            // Update barcodes.
-            firstCloneNext.Update(true, firstHasLargePatterns);
-            secondCloneNext.Update(true, secondHasLargePatterns);
-
-            // Replace barcodes of the next iteration.
-            firstClone.SetStringRepresentation(firstCloneNext.GetStringRepresentation());
-            secondClone.SetStringRepresentation(secondCloneNext.GetStringRepresentation());
-
-            // Count the number of "live" cells in each.
-            firstCount = firstClone.CountLiveCells();
-            secondCount = secondClone.CountLiveCells();
-
-            if (firstCount == 0 || firstCount == std::pow(GlobalSettings::BarcodeSize, 2) || secondCount == 0 || secondCount == std::pow(GlobalSettings::BarcodeSize, 2)) break;
+            outcome = Play(firstBits, firstGenes.Rules, firstGenes.HasLargePatterns, secondBits, secondGenes.Rules, secondGenes.HasLargePatterns);
+            if (GlobalSettings::UseInteractionCache) InteractionCache::Instance().Insert(firstGenes.Rules, firstBits, secondGenes.Rules, secondBits, outcome);
         }
 
         // Kill any that have zero cells.
-        if (firstCount == 0 || firstCount == std::pow(GlobalSettings::BarcodeSize, 2)) first.Kill();
-        if (secondCount == 0 || secondCount == std::pow(GlobalSettings::BarcodeSize, 2)) second.Kill();
+        if (outcome.FirstDies) first.Kill();
+        if (outcome.SecondDies) second.Kill();
 
         // If chromosomes have to be equal length, check to make sure.
-        if (GlobalSettings::ForceEqualChromosomeReproductions && first.ItsGeneticCode.Length() != second.ItsGeneticCode.Length()) return nullptr;
+        if (GlobalSettings::ForceEqualChromosomeReproductions && first.ItsGeneticCode.Length() != second.ItsGeneticCode.Length()) return {};
 
         // If any of the two are not yet of reproductive age, do nothing.
-        if (first.Age < first.ItsGeneticCode.ReproductiveAge || second.Age < second.ItsGeneticCode.ReproductiveAge) return nullptr;
+        if (first.GetAge() < first.ItsGeneticCode.ReproductiveAge || second.GetAge() < second.ItsGeneticCode.ReproductiveAge) return {};
 
         // If both are still alive and they are genetically compatible, let's reproduce!
         // Otherwise nothing happens.
         if (first.IsAlive() && second.IsAlive())
         {
-            const auto& offspring = Reproduce(first, second);
-            if (offspring != nullptr)
+            auto offspring = Reproduce(first, second, rng);
+            if (offspring.Handle.IsValid())
             {
-                offspring->Vitality = std::min(first.Vitality, GlobalSettings::MaxVitality / 4) + std::min(second.Vitality, GlobalSettings::MaxVitality / 4);
-                first.Vitality -= std::min(first.Vitality, GlobalSettings::MaxVitality / 4);
-                second.Vitality -= std::min(second.Vitality, GlobalSettings::MaxVitality / 4);
-
-                if (first.Vitality <= 0) first.Kill();
-                if (second.Vitality <= 0) second.Kill();
+                const auto firstShare = std::min(first.GetVitality(), GlobalSettings::MaxVitality / 4);
+                const auto secondShare = std::min(second.GetVitality(), GlobalSettings::MaxVitality / 4);
+                offspring.Vitality = firstShare + secondShare;
+                first.SetVitality(first.GetVitality() - firstShare);
+                second.SetVitality(second.GetVitality() - secondShare);
+
+                if (first.GetVitality() <= 0) first.Kill();
+                if (second.GetVitality() <= 0) second.Kill();
             }
 
             return offspring;
         }
 
-        return nullptr;
+        return {};
+    }
+
+
+    /// Plays two barcodes against each other: each step, each keeps the cells
+    /// the other does not have and steps under its own genes, until one is
+    /// emptied or filled or GlobalSettings::NumInteractionUpdates steps have
+    /// passed. Works on copies of the bits alone, so nothing is allocated.
+    /// Stops early once the pair returns to an earlier state (found with
+    /// Brent's method), since the states of the cycle have all been checked.
+    InteractionOutcome Interactor::Play(const BarcodeBits& first, const RuleTable& firstRules, bool firstHasLargePatterns, const BarcodeBits& second, const RuleTable& secondRules, bool secondHasLargePatterns)
+    {
+        const auto numCells = GlobalSettings::BarcodeSize * GlobalSettings::BarcodeSize;
+
+        InteractionOutcome outcome;
+        auto firstBits = first;
+        auto secondBits = second;
+        auto savedFirst = first;
+        auto savedSecond = second;
+        auto power = 1;
+        auto length = 0;
+
+        for (auto i = 0; i < GlobalSettings::NumInteractionUpdates; ++i)
+        {
+            // Keep the complement of the intersection.
+            BarcodeBits firstKept, secondKept;
+            for (auto w = 0; w < 4; ++w)
+            {
+                firstKept[w] = firstBits[w] & ~secondBits[w];
+                secondKept[w] = secondBits[w] & ~firstBits[w];
+            }
+
+            firstBits = Barcode::Step(firstKept, firstRules, firstHasLargePatterns);
+            secondBits = Barcode::Step(secondKept, secondRules, secondHasLargePatterns);
+
+            // Count the number of "live" cells in each; emptied or filled barcodes die.
+            const auto firstCount = Helpers::PopCount(firstBits);
+            const auto secondCount = Helpers::PopCount(secondBits);
+            outcome.FirstDies = firstCount == 0 || firstCount == numCells;
+            outcome.SecondDies = secondCount == 0 || secondCount == numCells;
+            if (outcome.FirstDies || outcome.SecondDies) break;
+
+            if (firstBits == savedFirst && secondBits == savedSecond) break;
+            if (++length == power)
+            {
+                savedFirst = firstBits;
+                savedSecond = secondBits;
+                power *= 2;
+                length = 0;
+            }
+        }
+
+        return outcome;
     }
 
 
     /// Reproduces by randomly selecting each gene from one of the individuals,
     /// inserts/deletes new genes, and applies mutation.
-    Individual* Interactor::Reproduce(Individual& first, Individual& second)
+    Offspring Interactor::Reproduce(Individual& first, Individual& second, RandomStream& rng)
     {
         std::uniform_real_distribution<> dist(0.0, 1.0);
 
@@ -105,170 +142,157 @@ namespace ABME
         if (GlobalSettings::MutationRatesEvolve)
         {
             // Crossover parameter mutation rate.
-            newGeneticCode.SetFlipMutationParameter(Helpers::Crossover(firstGenetics.GetFlipMutationParameter(), secondGenetics.GetFlipMutationParameter(), dist));
-            newGeneticCode.SetMetaMutationParameter(Helpers::Crossover(firstGenetics.GetMetaMutationParameter(), secondGenetics.GetMetaMutationParameter(), dist));
+            newGeneticCode.SetFlipMutationParameter(Helpers::Crossover(firstGenetics.GetFlipMutationParameter(), secondGenetics.GetFlipMutationParameter(), dist, rng));
+            newGeneticCode.SetMetaMutationParameter(Helpers::Crossover(firstGenetics.GetMetaMutationParameter(), secondGenetics.GetMetaMutationParameter(), dist, rng));
 
             // Mutate parameter rates.
-            Helpers::BitFlip(firstGenetics.GetMetaMutationParameter(), dist, newGeneticCode.GetMetaMutationRate());
-            Helpers::BitFlip(firstGenetics.GetFlipMutationParameter(), dist, newGeneticCode.GetMetaMutationRate());
+            Helpers::BitFlip(firstGenetics.GetMetaMutationParameter(), dist, newGeneticCode.GetMetaMutationRate(), rng);
+            Helpers::BitFlip(firstGenetics.GetFlipMutationParameter(), dist, newGeneticCode.GetMetaMutationRate(), rng);
 
             // Crossover reproductive age and programmed death.
-            newGeneticCode.ReproductiveAge = Helpers::Crossover(firstGenetics.ReproductiveAge, secondGenetics.ReproductiveAge, dist);
-            newGeneticCode.ProgrammedLifespan = Helpers::Crossover(firstGenetics.ProgrammedLifespan, secondGenetics.ProgrammedLifespan, dist);
+            newGeneticCode.ReproductiveAge = Helpers::Crossover(firstGenetics.ReproductiveAge, secondGenetics.ReproductiveAge, dist, rng);
+            newGeneticCode.ProgrammedLifespan = Helpers::Crossover(firstGenetics.ProgrammedLifespan, secondGenetics.ProgrammedLifespan, dist, rng);
 
             // Mutate reproductive age and programmed death.
-            Helpers::BitFlip(newGeneticCode.ReproductiveAge, dist, newGeneticCode.GetFlipMutationRate());
-            Helpers::BitFlip(newGeneticCode.ProgrammedLifespan, dist, newGeneticCode.GetFlipMutationRate());
+            Helpers::BitFlip(newGeneticCode.ReproductiveAge, dist, newGeneticCode.GetFlipMutationRate(), rng);
+            Helpers::BitFlip(newGeneticCode.ProgrammedLifespan, dist, newGeneticCode.GetFlipMutationRate(), rng);
         }
         
         // Recombine both chromosomes.
-        newGeneticCode.BehaviourGenes = RecombineChromosomes(firstGenetics.BehaviourGenes, secondGenetics.BehaviourGenes, dist, newGeneticCode.GetMetaMutationRate());
-        newGeneticCode.InteractionGenes = RecombineChromosomes(firstGenetics.InteractionGenes, secondGenetics.InteractionGenes, dist, newGeneticCode.GetMetaMutationRate());
+        newGeneticCode.BehaviourGenes = RecombineChromosomes(firstGenetics.BehaviourGenes, secondGenetics.BehaviourGenes, dist, newGeneticCode.GetMetaMutationRate(), rng);
+        newGeneticCode.InteractionGenes = RecombineChromosomes(firstGenetics.InteractionGenes, secondGenetics.InteractionGenes, dist, newGeneticCode.GetMetaMutationRate(), rng);
 
         // Create an individual with this chromosome.
-        auto offspring = new Individual(first.ItsEnvironment, newGeneticCode);
-        offspring->X = first.X;
-        offspring->Y = first.Y;
+        auto& pool = first.ItsEnvironment.GetPool();
+        const auto handle = pool.Create(first.ItsEnvironment, newGeneticCode);
+        auto* offspring = pool.Get(handle);
 
         // Perform the birth sequence.
         if (offspring->BeBorn())
         {
-            return offspring;
+            return { handle, first.GetX(), first.GetY(), GlobalSettings::MaxVitality / 2 };
         }
         
         // If there is no food tile to take, the offspring dies.
-        delete offspring;
-        return nullptr;
+        pool.Release(handle);
+        return {};
     }
 
 
     template <typename TChr>
-    Chromosome<TChr> Interactor::RecombineChromosomes(Chromosome<TChr>& first, Chromosome<TChr>& second, std::uniform_real_distribution<> dist, double metaMutationRate)
+    Chromosome<TChr> Interactor::RecombineChromosomes(Chromosome<TChr>& first, Chromosome<TChr>& second, std::uniform_real_distribution<> dist, double metaMutationRate, RandomStream& rng)
     {
         Chromosome<TChr> newChromosome(first.MaxGeneValue + 1);
 
         if (GlobalSettings::MutationRatesEvolve)
         {
             // Crossover metamutation parameters.
-            newChromosome.SetFlipMutationParameter(Helpers::Crossover(first.GetFlipMutationParameter(), second.GetFlipMutationParameter(), dist));
-            newChromosome.SetInsertionMutationParameter(Helpers::Crossover(first.GetInsertionMutationParameter(), second.GetInsertionMutationParameter(), dist));
-            if (!GlobalSettings::UseSingleStructuralMutationRate) newChromosome.SetDeletionMutationParameter(Helpers::Crossover(first.GetDeletionMutationParameter(), second.GetDeletionMutationParameter(), dist));
-            newChromosome.SetTransMutationParameter(Helpers::Crossover(first.GetTransMutationParameter(), second.GetTransMutationParameter(), dist));
+            newChromosome.SetFlipMutationParameter(Helpers::Crossover(first.GetFlipMutationParameter(), second.GetFlipMutationParameter(), dist, rng));
+            newChromosome.SetInsertionMutationParameter(Helpers::Crossover(first.GetInsertionMutationParameter(), second.GetInsertionMutationParameter(), dist, rng));
+            if (!GlobalSettings::UseSingleStructuralMutationRate) newChromosome.SetDeletionMutationParameter(Helpers::Crossover(first.GetDeletionMutationParameter(), second.GetDeletionMutationParameter(), dist, rng));
+            newChromosome.SetTransMutationParameter(Helpers::Crossover(first.GetTransMutationParameter(), second.GetTransMutationParameter(), dist, rng));
 
             // Mutate mutation parameters.
-            Helpers::BitFlip(newChromosome.GetFlipMutationParameter(), dist, metaMutationRate);
-            Helpers::BitFlip(newChromosome.GetInsertionMutationParameter(), dist, metaMutationRate);
-            if (!GlobalSettings::UseSingleStructuralMutationRate) Helpers::BitFlip(newChromosome.GetDeletionMutationParameter(), dist, metaMutationRate);
-            Helpers::BitFlip(newChromosome.GetTransMutationParameter(), dist, metaMutationRate);
+            Helpers::BitFlip(newChromosome.GetFlipMutationParameter(), dist, metaMutationRate, rng);
+            Helpers::BitFlip(newChromosome.GetInsertionMutationParameter(), dist, metaMutationRate, rng);
+            if (!GlobalSettings::UseSingleStructuralMutationRate) Helpers::BitFlip(newChromosome.GetDeletionMutationParameter(), dist, metaMutationRate, rng);
+            Helpers::BitFlip(newChromosome.GetTransMutationParameter(), dist, metaMutationRate, rng);
         }
 
         // Pick a random length (from the two).
-        std::uniform_int_distribution<std::mt19937::result_type> distLength(std::min(first.Genes.size(), second.Genes.size()), std::max(first.Genes.size(), second.Genes.size()));
-        int newLength = distLength(GlobalSettings::RNG);
-
-        // Convert chromosomes to vectors of gene indices and values.
-        std::vector<int> geneIndices;
-        std::vector<uchar> geneValues;
-        Helpers::ConvertChromosomeToVectors(first.Genes, geneIndices, geneValues);
-        Helpers::ConvertChromosomeToVectors(second.Genes, geneIndices, geneValues);
-
-        std::uniform_int_distribution<std::mt19937::result_type> distIndex(0, first.Genes.size() + second.Genes.size() - 1);
-        std::uniform_int_distribution<std::mt19937::result_type> distGeneIndex(0, GlobalSettings::NumGenes - 1);
-        std::uniform_int_distribution<std::mt19937::result_type> distDeleteIndex(0, newLength - 1);
-        std::uniform_int_distribution<std::mt19937::result_type> distGeneValue(0, newChromosome.MaxGeneValue);
+        const auto firstLength = first.Genes.Count();
+        const auto secondLength = second.Genes.Count();
+        std::uniform_int_distribution<int> distLength(std::min(firstLength, secondLength), std::max(firstLength, secondLength));
+        const auto newLength = distLength(rng);
 
+        std::uniform_int_distribution<int> distGeneValue(0, newChromosome.MaxGeneValue);
         auto& newGenes = newChromosome.Genes;
 
         // Crossover active genes.
-        // Pick a gene randomly from the two chromosomes, and ignore it if it already exists.
-        for (auto i = 0; i < newLength;)
+        // Pick genes one at a time from the genes of both chromosomes, as if drawing
+        // from both lists until newLength distinct genes are found: a gene in both
+        // is twice as likely, and takes its value from the copy drawn. The genes
+        // drawn are excluded from the counts instead of redrawn. This costs a
+        // draw and a select over the words of a genome per gene of the child,
+        // so unlike the mutations below it still grows with the genome length.
+        auto firstLeft = first.Genes;
+        auto secondLeft = second.Genes;
+        auto firstCount = firstLength;
+        auto secondCount = secondLength;
+        for (auto i = 0; i < newLength; ++i)
         {
-            int index = distIndex(GlobalSettings::RNG);
-            auto geneIndex = geneIndices[index];
-            auto geneValue = geneValues[index];
-            if (newGenes.count(geneIndex) == 0)
+            const auto drawn = std::uniform_int_distribution<int>(0, firstCount + secondCount - 1)(rng);
+            const auto fromFirst = drawn < firstCount;
+            const auto geneIndex = fromFirst ? firstLeft.Select(drawn) : secondLeft.Select(drawn - firstCount);
+            newGenes.Set(geneIndex, fromFirst ? first.Genes.Get(geneIndex) : second.Genes.Get(geneIndex));
+
+            if (firstLeft.Contains(geneIndex))
             {
-                newGenes[geneIndex] = geneValue;
-                if (geneIndex >= 522) newChromosome.HasLargePatterns = true;
-                ++i;
+                firstLeft.Remove(geneIndex);
+                --firstCount;
             }
-        }
 
-        // Insert mutation.
-        if ((dist(GlobalSettings::RNG) < newChromosome.GetInsertionMutationRate()) && (newLength < GlobalSettings::NumGenes))
-        {
-            auto geneIndex = -1;
-            bool done = false;
-            while (!done)
+            if (secondLeft.Contains(geneIndex))
             {
-                geneIndex = distGeneIndex(GlobalSettings::RNG);
-                done = newGenes.count(geneIndex) == 0;
+                secondLeft.Remove(geneIndex);
+                --secondCount;
             }
+        }
 
-            uchar geneValue = distGeneValue(GlobalSettings::RNG);
-            newGenes[geneIndex] = geneValue;
-            if (geneIndex >= 522) newChromosome.HasLargePatterns = true;
+        // Insert mutation.
+        if ((dist(rng) < newChromosome.GetInsertionMutationRate()) && (newLength < GlobalSettings::NumGenes))
+        {
+            // Pick any gene not yet in the chromosome.
+            const auto geneIndex = newGenes.SelectAbsent(std::uniform_int_distribution<int>(0, GlobalSettings::NumGenes - newGenes.Count() - 1)(rng));
+            newGenes.Set(geneIndex, uchar(distGeneValue(rng)));
         }
 
         // Transmutation (replacement gene with new value).
-        if ((dist(GlobalSettings::RNG) < newChromosome.GetTransMutationRate()) && (newLength < GlobalSettings::NumGenes))
+        if ((dist(rng) < newChromosome.GetTransMutationRate()) && (newGenes.Count() < GlobalSettings::NumGenes))
         {
-            // Pick a random gene and change its number.
-            int changePosition = distDeleteIndex(GlobalSettings::RNG);
-
-            // Remake a new chromosome.
-            GeneSet transGenes;
-            int i = 0;
-            for (auto&[key, value] : newGenes)
-            {
-                if (i == changePosition)
-                {
-                    bool done = false;
-                    auto geneIndex = -1;
-                    while (!done)
-                    {
-                        geneIndex = distGeneIndex(GlobalSettings::RNG);
-                        done = newGenes.count(geneIndex) == 0;
-                    }
-                    if (geneIndex >= 522) newChromosome.HasLargePatterns = true;
-                    transGenes[geneIndex] = distGeneValue(GlobalSettings::RNG);
-                }
-                else
-                {
-                    transGenes[key] = value;
-                }
-
-                ++i;
-            }
-
-            newGenes = transGenes;
+            // Pick a random gene and change its number (to one not in the chromosome).
+            const auto geneIndex = newGenes.Select(std::uniform_int_distribution<int>(0, newLength - 1)(rng));
+            const auto newIndex = newGenes.SelectAbsent(std::uniform_int_distribution<int>(0, GlobalSettings::NumGenes - newGenes.Count() - 1)(rng));
+            newGenes.Remove(geneIndex);
+            newGenes.Set(newIndex, uchar(distGeneValue(rng)));
         }
 
         // Delete mutation.
-        if ((dist(GlobalSettings::RNG) < newChromosome.GetDeletionMutationRate()) && (newLength >= 2))
+        if ((dist(rng) < newChromosome.GetDeletionMutationRate()) && (newLength >= 2))
         {
             // Remove a random gene.
-            int removePosition = distDeleteIndex(GlobalSettings::RNG);
-            auto it = newGenes.begin();
-            for (auto i = 0; i < removePosition; ++i, ++it);
-            newGenes.erase(it);
+            newGenes.Remove(newGenes.Select(std::uniform_int_distribution<int>(0, newLength - 1)(rng)));
         }
 
         // Mutate.
-        // Note: only gene value is mutated here.
-        for (auto&[key, value] : newGenes)
+        // Note: only gene value is mutated here. Each gene mutates independently,
+        // so the gaps between mutated genes are geometric: only the mutated genes
+        // are visited. A rate of one (or more) mutates every gene, and has no
+        // geometric distribution.
+        const auto mutate = [&](int position)
         {
-            bool flip = dist(GlobalSettings::RNG) < newChromosome.GetFlipMutationRate();
-            if (flip ) 
+            const auto geneIndex = newGenes.Select(position);
+            if (newChromosome.MaxGeneValue == 1) newGenes.Set(geneIndex, uchar(1 - newGenes.Get(geneIndex))); // Simply flip
+            else
             {
-                if (newChromosome.MaxGeneValue == 1) value = 1 - value; // Simply flip
-                else
-                {
-                    // Otherwise simple choose from the set of possibilities.
-                    value = distGeneValue(GlobalSettings::RNG);
-                }
+                // Otherwise simple choose from the set of possibilities.
+                newGenes.Set(geneIndex, uchar(distGeneValue(rng)));
             }
+        };
+
+        const auto flipRate = newChromosome.GetFlipMutationRate();
+        const auto numGenes = newGenes.Count();
+        if (flipRate >= 1.0)
+        {
+            for (auto position = 0; position < numGenes; ++position) mutate(position);
         }
+        else if (flipRate > 0.0)
+        {
+            std::geometric_distribution<int> distGap(flipRate);
+            for (auto position = distGap(rng); position < numGenes; position += 1 + distGap(rng)) mutate(position);
+        }
+
+        newChromosome.HasLargePatterns = newGenes.HasFrom(522);
 
         return newChromosome;
     }
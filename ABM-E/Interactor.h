@@ -2,21 +2,44 @@
 
 #include <vector>
 #include "GeneticCode.h"
+#include "IndividualPool.h"
 
 namespace ABME
 {
     class Individual;
 
-    /// Interacts multiple individuals for reproduction or death.
+    /// An individual born in an interaction, with the state it joins the population with.
+    struct Offspring
+    {
+        IndividualHandle Handle;
+        int X = -1;
+        int Y = -1;
+        int Vitality = 0;
+    };
+
+
+    /// How an interaction between two barcodes ended: whether each dies of it
+    /// (emptied or filled).
+    struct InteractionOutcome
+    {
+        bool FirstDies = false;
+        bool SecondDies = false;
+    };
+
+
+    /// Interacts multiple individuals for reproduction or death. All randomness
+    /// comes from the stream passed in, so groups can interact concurrently.
+    /// Offspring are created in the environment's pool.
     class Interactor
     {
     public:
-        static std::vector<Individual*> Interact(std::vector<Individual*> colocations);
+        static std::vector<Offspring> Interact(const std::vector<Individual*>& colocations, RandomStream& rng);
+        static InteractionOutcome Play(const BarcodeBits& first, const RuleTable& firstRules, bool firstHasLargePatterns, const BarcodeBits& second, const RuleTable& secondRules, bool secondHasLargePatterns);
 
     protected:
-        static Individual* Interact(Individual& first, Individual& second);
-        static Individual* Reproduce(Individual& first, Individual& second);
+        static Offspring Interact(Individual& first, Individual& second, RandomStream& rng);
+        static Offspring Reproduce(Individual& first, Individual& second, RandomStream& rng);
         
-        template <typename T> static Chromosome<T> RecombineChromosomes(Chromosome<T>& first, Chromosome<T>& second, std::uniform_real_distribution<> dist, double metaMutationRate);
+        template <typename T> static Chromosome<T> RecombineChromosomes(Chromosome<T>& first, Chromosome<T>& second, std::uniform_real_distribution<> dist, double metaMutationRate, RandomStream& rng);
     };
 }
\ No newline at end of file
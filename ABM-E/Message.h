@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// Builds a message out of plain values, in the byte order of the machine
+    /// (the workers of a run share one).
+    class MessageWriter
+    {
+    public:
+        template <typename T>
+        inline void Write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written.");
+            const auto offset = Bytes.size();
+            Bytes.resize(offset + sizeof(T));
+            std::memcpy(&Bytes[offset], &value, sizeof(T));
+        }
+
+
+        std::vector<uchar> Bytes;
+    };
+
+
+    /// Reads back the values of a message in the order they were written.
+    class MessageReader
+    {
+    public:
+        MessageReader(const std::vector<uchar>& bytes) : Bytes(bytes)
+        {
+
+        }
+
+
+        inline bool AtEnd() const
+        {
+            return Offset == Bytes.size();
+        }
+
+
+        template <typename T>
+        inline T Read()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read.");
+            if (Offset + sizeof(T) > Bytes.size()) throw std::runtime_error("Message is truncated.");
+
+            T value;
+            std::memcpy(&value, &Bytes[Offset], sizeof(T));
+            Offset += sizeof(T);
+            return value;
+        }
+
+    protected:
+        const std::vector<uchar>& Bytes;
+        size_t Offset = 0;
+    };
+}
\ No newline at end of file
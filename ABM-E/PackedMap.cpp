@@ -0,0 +1,169 @@
+#include "PackedMap.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ABME
+{
+    PackedMap::Chunk::Chunk()
+    {
+        for (auto& row : Rows) row.store(0, std::memory_order_relaxed);
+    }
+
+
+    PackedMap::~PackedMap()
+    {
+        Reset(0, 0);
+    }
+
+
+    /// Copies an area of another map of the same size, replacing what was there.
+    void PackedMap::Copy(const PackedMap& map, const cv::Rect& area)
+    {
+        for (auto y = area.y; y < area.y + area.height; ++y)
+        {
+            for (auto x = area.x; x < area.x + area.width; x += RowLength)
+            {
+                const auto length = std::min(RowLength, area.x + area.width - x);
+                AssignRow(x, y, map.GetRow(x, y), (1 << length) - 1);
+            }
+        }
+    }
+
+
+    std::string PackedMap::GetStatistics() const
+    {
+        std::stringstream statistics;
+        statistics << NumChunks << " of " << size_t(ChunksPerRow - 1) * ChunkRows << " chunks allocated (" << NumChunks * sizeof(Chunk) / 1024 << " KB)";
+
+        return statistics.str();
+    }
+
+
+    /// Frees the chunks that have emptied since the last call and still have
+    /// no set tiles. Not to be called while the map is in use elsewhere.
+    void PackedMap::ReleaseEmpty()
+    {
+        for (auto slot : Emptied)
+        {
+            auto* chunk = Chunks[slot].load(std::memory_order_relaxed);
+            if (chunk == nullptr || chunk->NumSet.load(std::memory_order_relaxed) > 0) continue;
+
+            Chunks[slot].store(nullptr, std::memory_order_relaxed);
+            delete chunk;
+            --NumChunks;
+        }
+
+        Emptied.clear();
+    }
+
+
+    /// Resizes the map, clearing every tile.
+    void PackedMap::Reset(int width, int height)
+    {
+        for (size_t i = 0; i < size_t(ChunksPerRow) * ChunkRows; ++i) delete Chunks[i].load(std::memory_order_relaxed);
+
+        Width = width;
+        Height = height;
+        ChunksPerRow = (width + ChunkSize - 1) / ChunkSize + 1;
+        ChunkRows = (height + ChunkSize - 1) / ChunkSize;
+        Chunks.reset(new std::atomic<Chunk*>[size_t(ChunksPerRow) * ChunkRows]);
+        for (size_t i = 0; i < size_t(ChunksPerRow) * ChunkRows; ++i) Chunks[i].store(nullptr, std::memory_order_relaxed);
+        NumChunks = 0;
+        Emptied.clear();
+    }
+
+
+    /// Sets or clears a tile. Returns whether it changed.
+    bool PackedMap::Set(int x, int y, bool value)
+    {
+        const auto bit = std::uint64_t(1) << (x & ChunkMask);
+        auto* chunk = value ? Allocate(x, y) : GetChunk(x, y);
+        if (chunk == nullptr) return false;
+
+        auto& row = chunk->Rows[y & ChunkMask];
+        const auto old = value ? row.fetch_or(bit, std::memory_order_relaxed) : row.fetch_and(~bit, std::memory_order_relaxed);
+        if (bool(old & bit) == value) return false;
+
+        Count(x, y, *chunk, value ? 1 : -1);
+        return true;
+    }
+
+
+    /// Unpacks the map, one byte per tile (255 if set).
+    cv::Mat PackedMap::ToMat() const
+    {
+        cv::Mat map(Height, Width, CV_8UC1, cv::Scalar(0));
+        for (auto y = 0; y < Height; ++y)
+        {
+            auto* tiles = map.ptr<uchar>(y);
+            for (auto x = 0; x < Width; x += ChunkSize)
+            {
+                const auto word = GetWord(x, y);
+                if (word == 0) continue;
+
+                for (auto i = 0; i < std::min(ChunkSize, Width - x); ++i)
+                {
+                    if ((word >> i) & 1) tiles[x + i] = 255;
+                }
+            }
+        }
+
+        return map;
+    }
+
+
+    /// Returns the chunk holding (x, y), allocating it if there is none.
+    /// Threads racing to allocate the same chunk all get the one that won.
+    PackedMap::Chunk* PackedMap::Allocate(int x, int y)
+    {
+        auto& slot = Chunks[GetSlot(x, y)];
+        auto* chunk = slot.load(std::memory_order_acquire);
+        if (chunk != nullptr) return chunk;
+
+        auto* created = new Chunk();
+        if (!slot.compare_exchange_strong(chunk, created, std::memory_order_acq_rel))
+        {
+            delete created;
+            return chunk;
+        }
+
+        ++NumChunks;
+        return created;
+    }
+
+
+    /// Replaces the tiles from (x, y) rightwards whose mask bits are set.
+    void PackedMap::AssignRow(int x, int y, int bits, int mask)
+    {
+        const auto shift = x & ChunkMask;
+        AssignWord(x, y, std::uint64_t(bits) << shift, std::uint64_t(mask) << shift);
+        if (shift > ChunkSize - RowLength) AssignWord(x + ChunkSize, y, std::uint64_t(bits) >> (ChunkSize - shift), std::uint64_t(mask) >> (ChunkSize - shift));
+    }
+
+
+    /// Replaces the bits of the chunk row holding (x, y) whose mask bits are set.
+    void PackedMap::AssignWord(int x, int y, std::uint64_t bits, std::uint64_t mask)
+    {
+        bits &= mask;
+        auto* chunk = bits != 0 ? Allocate(x, y) : GetChunk(x, y);
+        if (chunk == nullptr) return;
+
+        auto& row = chunk->Rows[y & ChunkMask];
+        const auto old = row.load(std::memory_order_relaxed);
+        const auto updated = (old & ~mask) | bits;
+        row.store(updated, std::memory_order_relaxed);
+        Count(x, y, *chunk, Helpers::PopCount(updated) - Helpers::PopCount(old));
+    }
+
+
+    /// Adds to the set tiles of the chunk holding (x, y), listing it if that empties it.
+    void PackedMap::Count(int x, int y, Chunk& chunk, int change)
+    {
+        if (change == 0) return;
+        if (chunk.NumSet.fetch_add(change, std::memory_order_relaxed) + change > 0) return;
+
+        std::lock_guard<std::mutex> lock(EmptiedMutex);
+        Emptied.push_back(GetSlot(x, y));
+    }
+}
\ No newline at end of file
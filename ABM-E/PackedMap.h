@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// A binary map packed one bit per tile in chunks of 64x64 tiles (a word
+    /// per chunk row). Chunks are allocated when a tile in them is first set
+    /// and released by ReleaseEmpty once they have no set tiles, so memory
+    /// follows the occupied area rather than the size of the map. Chunks are
+    /// listed as they empty, so ReleaseEmpty only visits those. Barcodes
+    /// are read and written a row at a time, a row spanning at most two
+    /// chunks. Tiles may be set concurrently from many threads; rows are
+    /// written by one thread at a time.
+    class PackedMap
+    {
+    public:
+        PackedMap() = default;
+        ~PackedMap();
+
+        PackedMap(const PackedMap&) = delete;
+        PackedMap& operator=(const PackedMap&) = delete;
+
+        void Copy(const PackedMap& map, const cv::Rect& area);
+        std::string GetStatistics() const;
+        void ReleaseEmpty();
+        void Reset(int width, int height);
+        bool Set(int x, int y, bool value);
+        cv::Mat ToMat() const;
+
+        /// Returns whether the tile at (x, y) is set.
+        inline bool Get(int x, int y) const
+        {
+            const auto* chunk = GetChunk(x, y);
+            return chunk != nullptr && (chunk->Rows[y & ChunkMask].load(std::memory_order_relaxed) >> (x & ChunkMask)) & 1;
+        }
+
+
+        /// Returns the 16 tiles from (x, y) rightwards, tile x + i in bit i.
+        inline int GetRow(int x, int y) const
+        {
+            const auto shift = x & ChunkMask;
+            auto bits = GetWord(x, y) >> shift;
+            if (shift > ChunkSize - RowLength) bits |= GetWord(x + ChunkSize, y) << (ChunkSize - shift);
+            return int(bits & 0xFFFF);
+        }
+
+
+        /// Sets the tiles from (x, y) rightwards whose bits are set (tile x + i for bit i).
+        inline void OrRow(int x, int y, int bits)
+        {
+            AssignRow(x, y, bits, bits);
+        }
+
+
+        inline int GetHeight() const
+        {
+            return Height;
+        }
+
+
+        inline int GetWidth() const
+        {
+            return Width;
+        }
+
+
+        static constexpr int RowLength = 16;
+        static constexpr int ChunkSize = 64;
+
+    protected:
+        struct Chunk
+        {
+            Chunk();
+
+            std::atomic<std::uint64_t> Rows[ChunkSize];
+            std::atomic<int> NumSet{ 0 };
+        };
+
+        static constexpr int ChunkMask = ChunkSize - 1;
+
+        Chunk* Allocate(int x, int y);
+        void AssignRow(int x, int y, int bits, int mask);
+        void AssignWord(int x, int y, std::uint64_t bits, std::uint64_t mask);
+        void Count(int x, int y, Chunk& chunk, int change);
+
+        inline size_t GetSlot(int x, int y) const
+        {
+            return size_t(y / ChunkSize) * ChunksPerRow + x / ChunkSize;
+        }
+
+
+        inline Chunk* GetChunk(int x, int y) const
+        {
+            return Chunks[GetSlot(x, y)].load(std::memory_order_acquire);
+        }
+
+
+        inline std::uint64_t GetWord(int x, int y) const
+        {
+            const auto* chunk = GetChunk(x, y);
+            return chunk != nullptr ? chunk->Rows[y & ChunkMask].load(std::memory_order_relaxed) : 0;
+        }
+
+
+        int Width = 0;
+        int Height = 0;
+        int ChunksPerRow = 0; // With a spare column, so a row starting in the last chunk can read past it.
+        int ChunkRows = 0;
+        std::unique_ptr<std::atomic<Chunk*>[]> Chunks;
+        std::atomic<int> NumChunks{ 0 };
+        std::vector<size_t> Emptied; // Slots of chunks whose last set tile was cleared (possibly repeated).
+        std::mutex EmptiedMutex;
+    };
+}
\ No newline at end of file
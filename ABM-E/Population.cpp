@@ -0,0 +1,113 @@
+#include "Population.h"
+
+#include "Individual.h"
+
+namespace ABME
+{
+    Population::Population(IndividualPool& pool) : Pool(pool)
+    {
+
+    }
+
+
+    Population::~Population()
+    {
+        Clear();
+    }
+
+
+    /// Appends a pooled individual, which the population then owns. Returns its row.
+    int Population::Add(IndividualHandle handle, int x, int y, int age, int vitality)
+    {
+        const auto row = Size();
+        auto& individual = *Pool.Get(handle);
+        individual.ItsPopulation = this;
+        individual.Row = row;
+
+        Handles.push_back(handle);
+        X.push_back(x);
+        Y.push_back(y);
+        Age.push_back(age);
+        Vitality.push_back(vitality);
+        Alive.push_back(1);
+        Barcodes.push_back(individual.CurrentBarcode.GetBits());
+        SnapshotX.push_back(-1);
+        SnapshotY.push_back(-1);
+        SnapshotBarcodes.push_back({});
+
+        return row;
+    }
+
+
+    /// Releases every individual.
+    void Population::Clear()
+    {
+        for (auto handle : Handles) Pool.Release(handle);
+
+        Handles.clear();
+        X.clear();
+        Y.clear();
+        Age.clear();
+        Vitality.clear();
+        Alive.clear();
+        Barcodes.clear();
+        SnapshotX.clear();
+        SnapshotY.clear();
+        SnapshotBarcodes.clear();
+    }
+
+
+    /// Releases the dead, moving the survivors' rows down in a single pass.
+    /// Returns the number released.
+    int Population::RemoveDead()
+    {
+        return RemoveWhere(Alive, 0);
+    }
+
+
+    /// Releases the rows whose flag has the given value, moving the others'
+    /// rows down in a single pass. Returns the number released.
+    int Population::RemoveWhere(const std::vector<char>& flags, char value)
+    {
+        auto numKept = 0;
+        for (auto row = 0; row < Size(); ++row)
+        {
+            if (flags[row] == value)
+            {
+                Pool.Release(Handles[row]);
+                continue;
+            }
+
+            if (row != numKept)
+            {
+                Handles[numKept] = Handles[row];
+                X[numKept] = X[row];
+                Y[numKept] = Y[row];
+                Age[numKept] = Age[row];
+                Vitality[numKept] = Vitality[row];
+                Alive[numKept] = Alive[row];
+                Barcodes[numKept] = Barcodes[row];
+                SnapshotX[numKept] = SnapshotX[row];
+                SnapshotY[numKept] = SnapshotY[row];
+                SnapshotBarcodes[numKept] = SnapshotBarcodes[row];
+                Pool.Get(Handles[numKept])->Row = numKept;
+            }
+
+            ++numKept;
+        }
+
+        const auto removed = Size() - numKept;
+        Handles.resize(numKept);
+        X.resize(numKept);
+        Y.resize(numKept);
+        Age.resize(numKept);
+        Vitality.resize(numKept);
+        Alive.resize(numKept);
+        Barcodes.resize(numKept);
+        SnapshotX.resize(numKept);
+        SnapshotY.resize(numKept);
+        SnapshotBarcodes.resize(numKept);
+
+        return removed;
+    }
+}
\ No newline at end of file
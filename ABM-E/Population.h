@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "Helpers.h"
+#include "IndividualPool.h"
+
+namespace ABME
+{
+    class Individual;
+
+    /// The individuals of an environment, stored as a structure of arrays: one
+    /// row per individual, with the state touched every step (position, age,
+    /// vitality, liveness and barcode) in contiguous arrays, and the genome,
+    /// compiled rules and barcode engine out of line in the pool. Per-step
+    /// loops over positions or barcodes stream through a few arrays instead of
+    /// visiting every individual. Rows are reordered only by RemoveDead and
+    /// RemoveWhere, which keep the remaining rows in order.
+    class Population
+    {
+    public:
+        Population(IndividualPool& pool);
+        ~Population();
+
+        Population(const Population&) = delete;
+        Population& operator=(const Population&) = delete;
+
+        int Add(IndividualHandle handle, int x, int y, int age, int vitality);
+        void Clear();
+        int RemoveDead();
+        int RemoveWhere(const std::vector<char>& flags, char value);
+
+        inline int Size() const
+        {
+            return int(Handles.size());
+        }
+
+
+        inline Individual& operator[](int row) const
+        {
+            return *Pool.Get(Handles[row]);
+        }
+
+
+        std::vector<IndividualHandle> Handles;
+        std::vector<int> X;
+        std::vector<int> Y;
+        std::vector<int> Age;
+        std::vector<int> Vitality;
+        std::vector<char> Alive; // Not vector<bool>, so rows can be written concurrently.
+        std::vector<BarcodeBits> Barcodes; // As of each individual's last update.
+
+        // Where and what each row last burnt into the environment's snapshot (X is -1 if nothing).
+        std::vector<int> SnapshotX;
+        std::vector<int> SnapshotY;
+        std::vector<BarcodeBits> SnapshotBarcodes;
+
+    protected:
+        IndividualPool& Pool;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "RegionMap.h"
+
+#include <sstream>
+
+namespace ABME
+{
+    /// Rasterises a region (clipped to the map) over the tiles no earlier
+    /// region has claimed. Chunks it covers whole become uniform; those its
+    /// edges cross store their tiles, and their summed-area tables are rebuilt.
+    void RegionMap::Add(const cv::Rect& region, int index)
+    {
+        const auto r = region & cv::Rect(0, 0, Width, Height);
+        if (r.area() == 0) return;
+
+        for (auto cy = r.y / ChunkSize; cy <= (r.y + r.height - 1) / ChunkSize; ++cy)
+        {
+            for (auto cx = r.x / ChunkSize; cx <= (r.x + r.width - 1) / ChunkSize; ++cx)
+            {
+                const auto c = size_t(cy) * ChunksPerRow + cx;
+                const auto area = cv::Rect(cx * ChunkSize, cy * ChunkSize, ChunkSize, ChunkSize) & cv::Rect(0, 0, Width, Height);
+                const auto part = r & area;
+                if (Chunks[c] == nullptr)
+                {
+                    if (Uniform[c] >= 0) continue;
+                    if (part == area)
+                    {
+                        Uniform[c] = index;
+                        continue;
+                    }
+
+                    Chunks[c].reset(new Chunk());
+                    Chunks[c]->Indices.fill(-1);
+                }
+
+                auto& indices = Chunks[c]->Indices;
+                for (auto y = part.y; y < part.y + part.height; ++y)
+                {
+                    for (auto x = part.x; x < part.x + part.width; ++x)
+                    {
+                        auto& tile = indices[(y & ChunkMask) * ChunkSize + (x & ChunkMask)];
+                        if (tile < 0) tile = index;
+                    }
+                }
+
+                // A chunk that ends up in a single region needs no tiles.
+                const auto first = indices[(area.y & ChunkMask) * ChunkSize + (area.x & ChunkMask)];
+                auto isUniform = true;
+                for (auto y = area.y; y < area.y + area.height && isUniform; ++y)
+                {
+                    for (auto x = area.x; x < area.x + area.width; ++x)
+                    {
+                        if (indices[(y & ChunkMask) * ChunkSize + (x & ChunkMask)] != first)
+                        {
+                            isUniform = false;
+                            break;
+                        }
+                    }
+                }
+
+                if (isUniform)
+                {
+                    Uniform[c] = first;
+                    Chunks[c].reset();
+                }
+                else Summarise(c);
+            }
+        }
+    }
+
+
+    std::string RegionMap::GetStatistics() const
+    {
+        size_t stored = 0;
+        for (auto& chunk : Chunks) stored += chunk != nullptr;
+
+        std::stringstream statistics;
+        statistics << stored << " of " << Chunks.size() << " chunks stored (" << stored * sizeof(Chunk) / 1024 << " KB)";
+
+        return statistics.str();
+    }
+
+
+    /// Resizes the map, removing every region.
+    void RegionMap::Reset(int width, int height)
+    {
+        Width = width;
+        Height = height;
+        ChunksPerRow = (width + ChunkSize - 1) / ChunkSize;
+        ChunkRows = (height + ChunkSize - 1) / ChunkSize;
+        Uniform.assign(size_t(ChunksPerRow) * ChunkRows, -1);
+        Chunks.clear();
+        Chunks.resize(size_t(ChunksPerRow) * ChunkRows);
+    }
+
+
+    /// Rebuilds the summed-area table of a stored chunk.
+    void RegionMap::Summarise(size_t c)
+    {
+        auto& chunk = *Chunks[c];
+        chunk.Allowed.fill(0);
+        for (auto y = 0; y < ChunkSize; ++y)
+        {
+            auto row = 0;
+            for (auto x = 0; x < ChunkSize; ++x)
+            {
+                row += chunk.Indices[y * ChunkSize + x] >= 0;
+                chunk.Allowed[(y + 1) * (ChunkSize + 1) + x + 1] = short(chunk.Allowed[y * (ChunkSize + 1) + x + 1] + row);
+            }
+        }
+    }
+}
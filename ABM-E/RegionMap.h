@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace ABME
+{
+    /// Rasterised regions: the index of the region each tile belongs to (-1
+    /// outside every region, the first region added winning where regions
+    /// overlap), and a summed-area table of the tiles inside some region.
+    /// The raster is kept in chunks of 64x64 tiles. A chunk lying in a single
+    /// region (or in none) is just that index; only chunks crossed by a region
+    /// edge store their tiles and a summed-area table of their own, so memory
+    /// follows the length of the region edges rather than the size of the
+    /// map. Point lookups are one or two reads, and the allowed area of a
+    /// rectangle is four reads per chunk it overlaps.
+    class RegionMap
+    {
+    public:
+        void Add(const cv::Rect& region, int index);
+        std::string GetStatistics() const;
+        void Reset(int width, int height);
+
+        /// Returns how many tiles of the rectangle are inside some region.
+        inline int CountAllowed(const cv::Rect& rect) const
+        {
+            const auto r = rect & cv::Rect(0, 0, Width, Height);
+            if (r.area() == 0) return 0;
+
+            auto count = 0;
+            for (auto cy = r.y / ChunkSize; cy <= (r.y + r.height - 1) / ChunkSize; ++cy)
+            {
+                for (auto cx = r.x / ChunkSize; cx <= (r.x + r.width - 1) / ChunkSize; ++cx)
+                {
+                    const auto part = r & cv::Rect(cx * ChunkSize, cy * ChunkSize, ChunkSize, ChunkSize);
+                    const auto c = size_t(cy) * ChunksPerRow + cx;
+                    if (Chunks[c] == nullptr)
+                    {
+                        if (Uniform[c] >= 0) count += part.area();
+                        continue;
+                    }
+
+                    const auto& allowed = Chunks[c]->Allowed;
+                    const auto x0 = part.x & ChunkMask;
+                    const auto y0 = part.y & ChunkMask;
+                    const auto x1 = x0 + part.width;
+                    const auto y1 = y0 + part.height;
+                    count += allowed[y1 * (ChunkSize + 1) + x1] - allowed[y0 * (ChunkSize + 1) + x1] - allowed[y1 * (ChunkSize + 1) + x0] + allowed[y0 * (ChunkSize + 1) + x0];
+                }
+            }
+
+            return count;
+        }
+
+
+        /// Returns whether every tile of the rectangle is inside some region.
+        inline bool Covers(const cv::Rect& rect) const
+        {
+            return CountAllowed(rect) == rect.area();
+        }
+
+
+        /// Returns the index of the region of a tile, or -1 if it is in none (or off the map).
+        inline int IndexAt(int x, int y) const
+        {
+            if (x < 0 || y < 0 || x >= Width || y >= Height) return -1;
+
+            const auto c = size_t(y / ChunkSize) * ChunksPerRow + x / ChunkSize;
+            return Chunks[c] == nullptr ? Uniform[c] : Chunks[c]->Indices[(y & ChunkMask) * ChunkSize + (x & ChunkMask)];
+        }
+
+
+        static constexpr int ChunkSize = 64;
+
+    protected:
+        struct Chunk
+        {
+            std::array<int, ChunkSize * ChunkSize> Indices;
+            std::array<short, (ChunkSize + 1) * (ChunkSize + 1)> Allowed; // Summed-area table, one larger each way.
+        };
+
+        static constexpr int ChunkMask = ChunkSize - 1;
+
+        void Summarise(size_t c);
+
+        int Width = 0;
+        int Height = 0;
+        int ChunksPerRow = 0;
+        int ChunkRows = 0;
+        std::vector<int> Uniform; // Per chunk, the index of all its tiles if it stores none.
+        std::vector<std::unique_ptr<Chunk>> Chunks; // Per chunk, its tiles if they differ.
+    };
+}
@@ -0,0 +1,126 @@
+#include "RuleCircuit.h"
+
+#include "Barcode.h"
+
+namespace ABME
+{
+    std::mutex RuleCircuit::CacheMutex;
+    std::map<GeneBits, std::weak_ptr<const RuleCircuit>> RuleCircuit::Cache;
+    size_t RuleCircuit::PruneThreshold = 1024;
+
+
+    size_t RuleCircuit::CacheSize()
+    {
+        std::lock_guard<std::mutex> lock(CacheMutex);
+        return Cache.size();
+    }
+
+
+    /// Evaluates the rule for every cell of the barcode at once. Only the
+    /// inner cells are meaningful. Requires IsCompact().
+    BarcodeBits RuleCircuit::Evaluate(const BarcodeBits& oldBarcode) const
+    {
+        BarcodeBits neighbours[9];
+        for (auto k = 0; k < 9; ++k)
+        {
+            if ((UsedVariables >> k & 1) == 0) continue;
+            neighbours[k] = Barcode::Shift(oldBarcode, (k / 3 - 1) * Barcode::Size + (k % 3 - 1));
+        }
+
+        BarcodeBits values[MaxNodes + 2];
+        values[0] = { 0, 0, 0, 0 };
+        values[1] = { ~0ULL, ~0ULL, ~0ULL, ~0ULL };
+        for (size_t i = 2; i < Nodes.size(); ++i)
+        {
+            auto& node = Nodes[i];
+            auto& selector = neighbours[node.Variable];
+            auto& low = values[node.Low];
+            auto& high = values[node.High];
+            for (auto w = 0; w < 4; ++w)
+            {
+                values[i][w] = low[w] ^ (selector[w] & (high[w] ^ low[w]));
+            }
+        }
+
+        return values[Root];
+    }
+
+
+    /// Returns the (possibly shared) circuit for the given genes and their compiled rules.
+    /// The cache is only locked to look the genes up and to insert the circuit, so
+    /// threads synthesising different genomes build in parallel.
+    std::shared_ptr<const RuleCircuit> RuleCircuit::Synthesise(const GeneBits& genes, const RuleTable& rules)
+    {
+        {
+            std::lock_guard<std::mutex> lock(CacheMutex);
+
+            auto cached = Cache.find(genes);
+            if (cached != Cache.end())
+            {
+                if (auto circuit = cached->second.lock()) return circuit;
+            }
+        }
+
+        // Truth table of the combined rule, indexed by the 9-bit neighbourhood code.
+        std::vector<uchar> truthTable(512);
+        for (auto code = 0; code < 512; ++code)
+        {
+            const auto centre = uchar((code >> 4) & 1);
+            auto value = rules.Rules9[code];
+            if (value == RuleTable::NoGene) value = rules.Rules3[(code >> 3) & 7];
+            if (value == RuleTable::NoGene) value = rules.Rules1[centre];
+            if (value == RuleTable::NoGene) value = centre;
+            truthTable[code] = value;
+        }
+
+        auto circuit = std::make_shared<RuleCircuit>();
+        circuit->Nodes.push_back({ -1, 0, 0 });
+        circuit->Nodes.push_back({ -1, 1, 1 });
+
+        std::map<std::tuple<int, int, int>, int> uniqueNodes;
+        circuit->Root = circuit->Build(truthTable, 0, 8, uniqueNodes);
+
+        std::lock_guard<std::mutex> lock(CacheMutex);
+
+        // Another thread may have built the same circuit meanwhile; share theirs.
+        auto& entry = Cache[genes];
+        if (auto existing = entry.lock()) return existing;
+        entry = circuit;
+
+        // Forget circuits no longer used by any genome, once in a while.
+        if (Cache.size() >= PruneThreshold)
+        {
+            for (auto it = Cache.begin(); it != Cache.end();)
+            {
+                if (it->second.expired()) it = Cache.erase(it);
+                else ++it;
+            }
+
+            PruneThreshold = std::max(size_t(1024), 2 * Cache.size());
+        }
+
+        return circuit;
+    }
+
+
+    /// Builds the reduced diagram of truthTable[begin, begin + 2^(variable + 1)),
+    /// splitting on the highest variable first. Returns the node index.
+    int RuleCircuit::Build(const std::vector<uchar>& truthTable, int begin, int variable, std::map<std::tuple<int, int, int>, int>& uniqueNodes)
+    {
+        if (variable < 0) return truthTable[begin];
+
+        const auto low = Build(truthTable, begin, variable - 1, uniqueNodes);
+        const auto high = Build(truthTable, begin + (1 << variable), variable - 1, uniqueNodes);
+        if (low == high) return low;
+
+        auto key = std::make_tuple(variable, low, high);
+        auto existing = uniqueNodes.find(key);
+        if (existing != uniqueNodes.end()) return existing->second;
+
+        Nodes.push_back({ variable, low, high });
+        UsedVariables |= 1 << variable;
+        uniqueNodes[key] = int(Nodes.size() - 1);
+
+        return int(Nodes.size() - 1);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "GeneBits.h"
+#include "Helpers.h"
+#include "RuleTable.h"
+
+namespace ABME
+{
+    /// A behaviour genome's combined 3x3 update rule (3x3 genes, falling back to
+    /// 3-cell, then 1-cell genes, then the old value), synthesised into a reduced
+    /// ordered binary decision diagram over the nine neighbour cells. Evaluated
+    /// on whole bitboards, each node costs one multiplexer per word, so a step
+    /// of all inner cells costs a handful of bitwise operations per node.
+    /// Circuits are shared between genomes with identical genes.
+    class RuleCircuit
+    {
+    public:
+        BarcodeBits Evaluate(const BarcodeBits& oldBarcode) const;
+
+        inline bool IsCompact() const
+        {
+            return Size() <= MaxNodes;
+        }
+
+
+        /// Returns the number of multiplexers (non-constant nodes).
+        inline size_t Size() const
+        {
+            return Nodes.size() - 2;
+        }
+
+
+        static size_t CacheSize();
+        static std::shared_ptr<const RuleCircuit> Synthesise(const GeneBits& genes, const RuleTable& rules);
+
+        static const int MaxNodes = 16; // Beyond this, the vectorised table lookup kernels are faster.
+
+    protected:
+        /// Node i evaluates to (Variable ? High : Low). Nodes 0 and 1 are the constants.
+        struct Node
+        {
+            int Variable;
+            int Low;
+            int High;
+        };
+
+        int Build(const std::vector<uchar>& truthTable, int begin, int variable, std::map<std::tuple<int, int, int>, int>& uniqueNodes);
+
+        std::vector<Node> Nodes;
+        int Root = 0;
+        int UsedVariables = 0; // Bit k is set if some node selects on neighbour k.
+
+        static std::mutex CacheMutex;
+        static std::map<GeneBits, std::weak_ptr<const RuleCircuit>> Cache;
+        static size_t PruneThreshold;
+    };
+}
\ No newline at end of file
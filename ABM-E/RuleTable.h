@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "Helpers.h"
+#include "SparseRuleTable.h"
+
+namespace ABME
+{
+    class RuleCircuit;
+
+    /// Lookup tables compiled from a gene set: dense ones for pattern sizes up to
+    /// 3x3, and a sparse one for 5x5 patterns. Tables are indexed by packed
+    /// neighbourhood codes, where bit k holds cell k of the row-major window (so
+    /// a row of a barcode bitboard shifted right by the window's first column
+    /// gives the code directly). The 5x5 table is instead indexed column by
+    /// column, so that the next window along a row is a shift and one new
+    /// column away. Absent genes map to NoGene.
+    class RuleTable
+    {
+    public:
+        RuleTable()
+        {
+            Clear();
+        }
+
+
+        inline void Clear()
+        {
+            Rules1.fill(NoGene);
+            Rules3.fill(NoGene);
+            Rules9.fill(NoGene);
+            Rules25.Clear();
+            Circuit.reset();
+            Fingerprint = 0;
+            Checksum = ChecksumSeed;
+        }
+
+
+        /// Rebuilds the tables from the genes (a GeneSet or GeneBits).
+        template <typename TGenes>
+        inline void Compile(const TGenes& genes)
+        {
+            Clear();
+
+            std::vector<std::pair<int, uchar>> rules25;
+            for (const auto [index, value] : genes)
+            {
+                const auto gene = std::uint64_t(index) << 8 | value;
+                Fingerprint = Helpers::HashCombine(Fingerprint, gene);
+                Checksum = Helpers::HashCombine(Checksum, ~gene);
+
+                if (index < 2) Rules1[index] = value;
+                else if (index < 10) Rules3[Helpers::ReverseBits(index - 2, 3)] = value;
+                else if (index < 522) Rules9[Helpers::ReverseBits(index - 10, 9)] = value;
+                else rules25.emplace_back(Helpers::TransposeWindow(Helpers::ReverseBits(index - 522, 25), 5), value);
+            }
+
+            Rules25.Build(rules25);
+        }
+
+
+        std::array<uchar, 2> Rules1;
+        std::array<uchar, 8> Rules3;
+        std::array<uchar, 512> Rules9;
+        SparseRuleTable Rules25;
+        std::shared_ptr<const RuleCircuit> Circuit; // Only synthesised for behaviour genes.
+        std::uint64_t Fingerprint = 0; // Hash of all genes, identifying the genome in caches.
+        std::uint64_t Checksum = ChecksumSeed; // Second, independently seeded hash, compared on cache hits.
+
+        static constexpr uchar NoGene = SparseRuleTable::NoGene;
+        static constexpr std::uint64_t ChecksumSeed = 0x243F6A8885A308D3ULL;
+    };
+}
\ No newline at end of file
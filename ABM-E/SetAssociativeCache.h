@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// A fixed-size map from keys to values that forgets entries when full. It
+    /// is set-associative with CLOCK replacement inside each set, and is safe
+    /// to use from many threads (sets are guarded by striped locks). TKey needs
+    /// operator== and a Hash() member picking the set.
+    template <typename TKey, typename TValue>
+    class SetAssociativeCache
+    {
+    public:
+        /// Creates a cache of at least numEntries entries (rounded up to a power-of-two number of sets).
+        SetAssociativeCache(int numEntries) : NumSets(1), Locks(new std::mutex[NumLocks])
+        {
+            while (NumSets * Ways < size_t(numEntries)) NumSets *= 2;
+
+            Entries.resize(NumSets * Ways);
+            Hands.resize(NumSets, 0);
+        }
+
+
+        /// Looks up the value stored for a key, counting hits and misses.
+        bool Find(const TKey& key, TValue& value)
+        {
+            const auto set = SetIndex(key);
+            {
+                std::lock_guard<std::mutex> lock(Locks[set % NumLocks]);
+
+                for (auto i = set * Ways; i < (set + 1) * Ways; ++i)
+                {
+                    auto& entry = Entries[i];
+                    if (entry.Valid && entry.Key == key)
+                    {
+                        entry.Referenced = true;
+                        value = entry.Value;
+                        Hits.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+
+            Misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+
+        double GetHitRate() const
+        {
+            const auto hits = Hits.load(std::memory_order_relaxed);
+            const auto total = hits + Misses.load(std::memory_order_relaxed);
+
+            return total > 0 ? double(hits) / total : 0.0;
+        }
+
+
+        std::string GetStatistics() const
+        {
+            std::stringstream statistics;
+            statistics << 100 * GetHitRate() << "% hits (" << Hits << " hits, " << Misses << " misses, " << Evictions << " evictions)";
+
+            return statistics.str();
+        }
+
+
+        /// Stores a value. When the set is full, the CLOCK hand evicts the
+        /// first entry not referenced since it last passed.
+        void Insert(const TKey& key, const TValue& value)
+        {
+            const auto set = SetIndex(key);
+            std::lock_guard<std::mutex> lock(Locks[set % NumLocks]);
+
+            auto* entries = &Entries[set * Ways];
+            for (auto i = 0; i < Ways; ++i)
+            {
+                // Another thread may have stored the same key.
+                if (entries[i].Valid && entries[i].Key == key) return;
+            }
+
+            auto& hand = Hands[set];
+            while (entries[hand].Valid && entries[hand].Referenced)
+            {
+                entries[hand].Referenced = false;
+                hand = (hand + 1) % Ways;
+            }
+
+            auto& entry = entries[hand];
+            if (entry.Valid) Evictions.fetch_add(1, std::memory_order_relaxed);
+
+            entry.Key = key;
+            entry.Value = value;
+            entry.Valid = true;
+            entry.Referenced = false;
+            hand = (hand + 1) % Ways;
+        }
+
+
+        std::atomic<std::uint64_t> Hits{ 0 };
+        std::atomic<std::uint64_t> Misses{ 0 };
+        std::atomic<std::uint64_t> Evictions{ 0 };
+
+    protected:
+        struct Entry
+        {
+            TKey Key = {};
+            TValue Value = {};
+            bool Valid = false;
+            bool Referenced = false;
+        };
+
+        inline size_t SetIndex(const TKey& key) const
+        {
+            return key.Hash() & (NumSets - 1);
+        }
+
+        static const int Ways = 8;
+        static const int NumLocks = 256;
+
+        size_t NumSets;
+        std::vector<Entry> Entries;
+        std::vector<uchar> Hands;
+        std::unique_ptr<std::mutex[]> Locks;
+    };
+}
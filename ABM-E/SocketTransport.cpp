@@ -0,0 +1,186 @@
+#include "SocketTransport.h"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace ABME
+{
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+    static const int SendFlags = MSG_NOSIGNAL; // A dead peer is an error, not a signal.
+#else
+    static const int SendFlags = 0;
+#endif
+
+
+    static void ReadAll(int socket, void* data, size_t size)
+    {
+        auto* bytes = static_cast<char*>(data);
+        while (size > 0)
+        {
+            const auto count = ::recv(socket, bytes, size, 0);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) throw std::runtime_error("Lost the connection to a worker.");
+
+            bytes += count;
+            size -= size_t(count);
+        }
+    }
+
+
+    static void WriteAll(int socket, const void* data, size_t size)
+    {
+        auto* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const auto count = ::send(socket, bytes, size, SendFlags);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) throw std::runtime_error("Lost the connection to a worker.");
+
+            bytes += count;
+            size -= size_t(count);
+        }
+    }
+#endif
+
+
+    SocketTransport::SocketTransport(int rank, std::vector<int> sockets) : Rank(rank), Sockets(std::move(sockets))
+    {
+
+    }
+
+
+    SocketTransport::~SocketTransport()
+    {
+#ifndef _WIN32
+        for (auto socket : Sockets)
+        {
+            if (socket >= 0) ::close(socket);
+        }
+#endif
+    }
+
+
+    int SocketTransport::GetRank() const
+    {
+        return Rank;
+    }
+
+
+    int SocketTransport::GetSize() const
+    {
+        return int(Sockets.size());
+    }
+
+
+    std::vector<uchar> SocketTransport::Receive(int peer)
+    {
+        std::vector<uchar> message;
+#ifndef _WIN32
+        std::uint64_t size = 0;
+        ReadAll(Sockets[peer], &size, sizeof(size));
+        message.resize(size_t(size));
+        if (size > 0) ReadAll(Sockets[peer], message.data(), message.size());
+#endif
+        return message;
+    }
+
+
+    void SocketTransport::Send(int peer, const std::vector<uchar>& message)
+    {
+#ifndef _WIN32
+        const auto size = std::uint64_t(message.size());
+        WriteAll(Sockets[peer], &size, sizeof(size));
+        if (size > 0) WriteAll(Sockets[peer], message.data(), message.size());
+#endif
+    }
+
+
+    /// Forks a number of workers, each running the work with its own
+    /// transport, and waits for them. Returns the number that failed. Must be
+    /// called before any OpenMP parallel region, since the thread pool does
+    /// not survive a fork.
+    int SocketTransport::Launch(int numWorkers, const std::function<void(Transport&)>& work)
+    {
+#ifdef _WIN32
+        throw std::runtime_error("Worker processes are not supported on Windows.");
+#else
+        // sockets[i][j] is worker i's end of the socket it shares with worker j.
+        std::vector<std::vector<int>> sockets(numWorkers, std::vector<int>(numWorkers, -1));
+        for (auto i = 0; i < numWorkers; ++i)
+        {
+            for (auto j = i + 1; j < numWorkers; ++j)
+            {
+                int pair[2];
+                if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) throw std::runtime_error("Couldn't connect the workers.");
+                sockets[i][j] = pair[0];
+                sockets[j][i] = pair[1];
+            }
+        }
+
+        std::cout.flush();
+
+        std::vector<pid_t> workers;
+        for (auto rank = 0; rank < numWorkers; ++rank)
+        {
+            const auto pid = ::fork();
+            if (pid < 0) throw std::runtime_error("Couldn't start a worker.");
+            if (pid > 0)
+            {
+                workers.push_back(pid);
+                continue;
+            }
+
+            // Keep only this worker's ends.
+            for (auto i = 0; i < numWorkers; ++i)
+            {
+                for (auto j = 0; j < numWorkers; ++j)
+                {
+                    if (i != rank && sockets[i][j] >= 0) ::close(sockets[i][j]);
+                }
+            }
+
+            auto status = 0;
+            try
+            {
+                SocketTransport transport(rank, sockets[rank]);
+                work(transport);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Worker " << rank << ": " << e.what() << std::endl;
+                status = 1;
+            }
+
+            std::cout.flush();
+            ::_exit(status);
+        }
+
+        for (auto& row : sockets)
+        {
+            for (auto socket : row)
+            {
+                if (socket >= 0) ::close(socket);
+            }
+        }
+
+        auto failures = 0;
+        for (auto pid : workers)
+        {
+            auto status = 0;
+            if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failures;
+        }
+
+        return failures;
+#endif
+    }
+}
\ No newline at end of file
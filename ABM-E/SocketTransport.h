@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include "Transport.h"
+
+namespace ABME
+{
+    /// Workers forked on this machine, connected pairwise by Unix domain
+    /// sockets. Each message is sent as its length followed by its bytes.
+    /// Not available on Windows.
+    class SocketTransport : public Transport
+    {
+    public:
+        ~SocketTransport();
+
+        SocketTransport(const SocketTransport&) = delete;
+        SocketTransport& operator=(const SocketTransport&) = delete;
+
+        int GetRank() const override;
+        int GetSize() const override;
+        std::vector<uchar> Receive(int peer) override;
+        void Send(int peer, const std::vector<uchar>& message) override;
+
+        static int Launch(int numWorkers, const std::function<void(Transport&)>& work);
+
+    protected:
+        SocketTransport(int rank, std::vector<int> sockets);
+
+        int Rank;
+        std::vector<int> Sockets; // One per peer (-1 for this worker).
+    };
+}
\ No newline at end of file
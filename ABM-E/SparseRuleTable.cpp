@@ -0,0 +1,53 @@
+#include "SparseRuleTable.h"
+
+#include <algorithm>
+
+namespace ABME
+{
+    /// Rebuilds the table from (code, value) pairs with distinct codes.
+    void SparseRuleTable::Build(const std::vector<std::pair<int, uchar>>& rules)
+    {
+        Clear();
+        if (rules.empty()) return;
+
+        size_t slots = 2;
+        while (slots < 2 * rules.size()) slots *= 2;
+
+        auto filterBits = MinFilterBits;
+        while (filterBits < MaxFilterBits && (size_t(1) << filterBits) < FilterBitsPerRule * rules.size()) ++filterBits;
+
+        Keys.assign(slots, int(EmptyKey));
+        Values.assign(slots, uchar(NoGene));
+        Filter.assign((size_t(1) << filterBits) / 64, 0);
+        SlotMask = slots - 1;
+        FilterMask = (std::uint32_t(1) << filterBits) - 1;
+        FilterShift = CodeBits - filterBits;
+
+        for (auto&[code, value] : rules)
+        {
+            const auto hash = Helpers::HashCombine(0, std::uint64_t(code));
+
+            auto slot = hash & SlotMask;
+            while (Keys[slot] != EmptyKey) slot = (slot + 1) & SlotMask;
+            Keys[slot] = code;
+            Values[slot] = value;
+
+            const auto bit = GetFilterBit(code);
+            Filter[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+        }
+
+        Count = rules.size();
+    }
+
+
+    void SparseRuleTable::Clear()
+    {
+        Keys.clear();
+        Values.clear();
+        Filter.clear();
+        SlotMask = 0;
+        FilterMask = 0;
+        FilterShift = 0;
+        Count = 0;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// A rule table over a large code space (the 2^25 5x5 neighbourhoods), holding
+    /// only the codes a genome has genes for. Codes are stored in an open-addressing
+    /// hash table (linear probing, at most half full), behind a bitmap indexed
+    /// directly by the code's bits folded in half, so that most codes without a
+    /// gene are rejected before they are hashed.
+    class SparseRuleTable
+    {
+    public:
+        void Build(const std::vector<std::pair<int, uchar>>& rules);
+        void Clear();
+
+        /// Returns the value of the gene for the code, or NoGene.
+        inline uchar Find(int code) const
+        {
+            if (Count == 0 || !MayContain(code)) return NoGene;
+
+            const auto hash = Helpers::HashCombine(0, std::uint64_t(code));
+            for (auto slot = hash & SlotMask; ; slot = (slot + 1) & SlotMask)
+            {
+                if (Keys[slot] == code) return Values[slot];
+                if (Keys[slot] == EmptyKey) return NoGene;
+            }
+        }
+
+
+        inline size_t Size() const
+        {
+            return Count;
+        }
+
+
+        static constexpr uchar NoGene = 255;
+
+    protected:
+        /// Returns the filter bit of a code: its high bits folded onto its low ones.
+        inline std::uint32_t GetFilterBit(int code) const
+        {
+            return (std::uint32_t(code) ^ (std::uint32_t(code) >> FilterShift)) & FilterMask;
+        }
+
+
+        /// Tests the filter bit of a code; false means the code has no gene.
+        inline bool MayContain(int code) const
+        {
+            const auto bit = GetFilterBit(code);
+            return ((Filter[bit >> 6] >> (bit & 63)) & 1) != 0;
+        }
+
+
+        std::vector<int> Keys;
+        std::vector<uchar> Values;
+        std::vector<std::uint64_t> Filter;
+        std::uint64_t SlotMask = 0;
+        std::uint32_t FilterMask = 0;
+        int FilterShift = 0;
+        size_t Count = 0;
+
+        static constexpr int EmptyKey = -1;
+        static const int FilterBitsPerRule = 32;
+        static const int CodeBits = 25;
+        static const int MinFilterBits = 13; // At least half the code bits, so that folding covers them all.
+        static const int MaxFilterBits = 24;
+    };
+}
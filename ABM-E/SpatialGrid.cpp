@@ -0,0 +1,75 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+
+namespace ABME
+{
+    /// Sorts the inserted positions, with two stable counting sorts (by y, then by x).
+    void SpatialGrid::Build()
+    {
+        std::vector<int> rowStarts(Height + 1, 0);
+        for (auto& entry : Entries) ++rowStarts[entry.Y + 1];
+        for (auto y = 0; y < Height; ++y) rowStarts[y + 1] += rowStarts[y];
+
+        Buffer.resize(Entries.size());
+        for (auto& entry : Entries) Buffer[rowStarts[entry.Y]++] = entry;
+
+        ColumnStarts.assign(Width + 1, 0);
+        for (auto& entry : Buffer) ++ColumnStarts[entry.X + 1];
+        for (auto x = 0; x < Width; ++x) ColumnStarts[x + 1] += ColumnStarts[x];
+
+        auto next = ColumnStarts;
+        for (auto& entry : Buffer) Entries[next[entry.X]++] = entry;
+    }
+
+
+    /// Returns the groups of two or more individuals at the same position,
+    /// ordered by position (x, then y), each in order of insertion.
+    std::vector<SpatialGrid::Colocation> SpatialGrid::FindColocations() const
+    {
+        std::vector<Colocation> colocations;
+        for (size_t begin = 0, end; begin < Entries.size(); begin = end)
+        {
+            end = begin + 1;
+            while (end < Entries.size() && Entries[end].X == Entries[begin].X && Entries[end].Y == Entries[begin].Y) ++end;
+            if (end - begin < 2) continue;
+
+            colocations.push_back({ Entries[begin].X, Entries[begin].Y, {} });
+            for (auto k = begin; k < end; ++k) colocations.back().Members.push_back(Entries[k].Who);
+        }
+
+        return colocations;
+    }
+
+
+    /// Appends a position. Positions must lie within the map; Build must be called before querying.
+    void SpatialGrid::Insert(int x, int y, IndividualHandle individual)
+    {
+        Entries.push_back({ x, y, individual });
+    }
+
+
+    /// Appends the individuals positioned (by their top-left corner) within the area.
+    void SpatialGrid::Query(const cv::Rect& area, std::vector<IndividualHandle>& found) const
+    {
+        const auto lessY = [](const Entry& entry, int y) { return entry.Y < y; };
+
+        for (auto x = std::max(area.x, 0); x < std::min(area.x + area.width, Width); ++x)
+        {
+            const auto columnEnd = Entries.begin() + ColumnStarts[x + 1];
+            for (auto it = std::lower_bound(Entries.begin() + ColumnStarts[x], columnEnd, area.y, lessY); it != columnEnd && it->Y < area.y + area.height; ++it)
+            {
+                found.push_back(it->Who);
+            }
+        }
+    }
+
+
+    void SpatialGrid::Reset(int width, int height)
+    {
+        Width = width;
+        Height = height;
+        Entries.clear();
+        ColumnStarts.assign(Width + 1, 0);
+    }
+}
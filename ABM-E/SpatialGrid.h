@@ -0,0 +1,49 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+#include "IndividualPool.h"
+
+namespace ABME
+{
+    /// Individuals indexed by position, rebuilt every step: positions are
+    /// appended, then radix sorted by (x, y), keeping the order of insertion
+    /// among equal positions. Each column of the map is a flat bucket sorted
+    /// by y, so both colocations and rectangle queries are contiguous runs.
+    class SpatialGrid
+    {
+    public:
+        /// Individuals sharing a position, in order of insertion.
+        struct Colocation
+        {
+            int X;
+            int Y;
+            std::vector<IndividualHandle> Members;
+        };
+
+        void Build();
+        std::vector<Colocation> FindColocations() const;
+        void Insert(int x, int y, IndividualHandle individual);
+        void Query(const cv::Rect& area, std::vector<IndividualHandle>& found) const;
+        void Reset(int width, int height);
+
+        inline size_t Size() const
+        {
+            return Entries.size();
+        }
+
+    protected:
+        struct Entry
+        {
+            int X;
+            int Y;
+            IndividualHandle Who;
+        };
+
+        int Width = 0;
+        int Height = 0;
+        std::vector<Entry> Entries;
+        std::vector<Entry> Buffer;
+        std::vector<int> ColumnStarts; // Entries of column x are [ColumnStarts[x], ColumnStarts[x + 1]).
+    };
+}
@@ -0,0 +1,196 @@
+#include "StepKernels.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ABME_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace ABME
+{
+    // Constant-initialised before Select() runs during dynamic initialisation.
+    StepKernels::KernelFunction StepKernels::Kernel = nullptr;
+    InstructionSet StepKernels::Selected = StepKernels::Select(StepKernels::Detect());
+
+    static const int BarcodeSize = GlobalSettings::BarcodeSize;
+    static const int InnerRowMask = 0x7FFE;
+
+
+    /// Writes the set/cleared cells of one row back into the barcode.
+    static inline void CommitRow(BarcodeBits& barcode, int row, int set, int cleared)
+    {
+        const auto shift = (row & 3) * BarcodeSize;
+        barcode[row >> 2] = (barcode[row >> 2] | std::uint64_t(set & InnerRowMask) << shift) & ~(std::uint64_t(cleared & InnerRowMask) << shift);
+    }
+
+
+    /// Returns the widest instruction set both compiled in and supported by this CPU.
+    InstructionSet StepKernels::Detect()
+    {
+#ifdef ABME_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return InstructionSetAVX512;
+        if (__builtin_cpu_supports("avx2")) return InstructionSetAVX2;
+#endif
+        return InstructionSetScalar;
+    }
+
+
+    const char* StepKernels::GetName(InstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+        case InstructionSetAVX512:
+            return "AVX-512";
+        case InstructionSetAVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+        }
+    }
+
+
+    InstructionSet StepKernels::GetSelected()
+    {
+        return Selected;
+    }
+
+
+    /// Selects the requested kernel, falling back to the widest supported one.
+    /// Returns the kernel actually selected.
+    InstructionSet StepKernels::Select(InstructionSet instructionSet)
+    {
+        Selected = std::min(instructionSet, Detect());
+
+        switch (Selected)
+        {
+        case InstructionSetAVX512:
+            Kernel = Step3x3AVX512;
+            break;
+        case InstructionSetAVX2:
+            Kernel = Step3x3AVX2;
+            break;
+        default:
+            Kernel = Step3x3Scalar;
+            break;
+        }
+
+        return Selected;
+    }
+
+
+    void StepKernels::Step3x3Scalar(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows)
+    {
+        for (auto j = 1; j < BarcodeSize - 1; ++j)
+        {
+            if (((rows >> j) & 1) == 0) continue;
+
+            const auto top = Helpers::GetRow(oldBarcode, j - 1);
+            const auto middle = Helpers::GetRow(oldBarcode, j);
+            const auto bottom = Helpers::GetRow(oldBarcode, j + 1);
+
+            auto set = 0;
+            auto cleared = 0;
+            for (auto i = 1; i < BarcodeSize - 1; ++i)
+            {
+                const auto code = ((top >> (i - 1)) & 7) | ((middle >> (i - 1)) & 7) << 3 | ((bottom >> (i - 1)) & 7) << 6;
+                const auto value = rules.Rules9[code];
+                set |= (value == 1) << i;
+                cleared |= (value == 0) << i;
+            }
+
+            CommitRow(barcode, j, set, cleared);
+        }
+    }
+
+
+#ifdef ABME_X86_KERNELS
+    /// Computes 8 codes per vector with per-lane shifts, and gathers the rule
+    /// values as the 32-bit table words holding them.
+    __attribute__((target("avx2")))
+    void StepKernels::Step3x3AVX2(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows)
+    {
+        const auto* table = reinterpret_cast<const int*>(rules.Rules9.data());
+        const __m256i seven = _mm256_set1_epi32(7);
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i shifts[2] = { _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15) };
+
+        for (auto j = 1; j < BarcodeSize - 1; ++j)
+        {
+            if (((rows >> j) & 1) == 0) continue;
+
+            const auto top = _mm256_set1_epi32(Helpers::GetRow(oldBarcode, j - 1));
+            const auto middle = _mm256_set1_epi32(Helpers::GetRow(oldBarcode, j));
+            const auto bottom = _mm256_set1_epi32(Helpers::GetRow(oldBarcode, j + 1));
+
+            auto set = 0;
+            auto cleared = 0;
+            for (auto half = 0; half < 2; ++half)
+            {
+                // Lane l holds column 8 * half + l + 1.
+                auto code = _mm256_and_si256(_mm256_srlv_epi32(top, shifts[half]), seven);
+                code = _mm256_or_si256(code, _mm256_slli_epi32(_mm256_and_si256(_mm256_srlv_epi32(middle, shifts[half]), seven), 3));
+                code = _mm256_or_si256(code, _mm256_slli_epi32(_mm256_and_si256(_mm256_srlv_epi32(bottom, shifts[half]), seven), 6));
+
+                const auto words = _mm256_i32gather_epi32(table, _mm256_srli_epi32(code, 2), 4);
+                const auto values = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_slli_epi32(_mm256_and_si256(code, _mm256_set1_epi32(3)), 3)), byteMask);
+
+                set |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, one))) << (8 * half + 1);
+                cleared |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, zero))) << (8 * half + 1);
+            }
+
+            CommitRow(barcode, j, set, cleared);
+        }
+    }
+
+
+    /// As the AVX2 kernel, with a whole row of codes per vector.
+    __attribute__((target("avx512f")))
+    void StepKernels::Step3x3AVX512(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows)
+    {
+        const auto* table = reinterpret_cast<const int*>(rules.Rules9.data());
+        const __m512i seven = _mm512_set1_epi32(7);
+        const __m512i three = _mm512_set1_epi32(3);
+        const __m512i byteMask = _mm512_set1_epi32(0xFF);
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i shifts = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        for (auto j = 1; j < BarcodeSize - 1; ++j)
+        {
+            if (((rows >> j) & 1) == 0) continue;
+
+            const auto top = _mm512_set1_epi32(Helpers::GetRow(oldBarcode, j - 1));
+            const auto middle = _mm512_set1_epi32(Helpers::GetRow(oldBarcode, j));
+            const auto bottom = _mm512_set1_epi32(Helpers::GetRow(oldBarcode, j + 1));
+
+            // Lane l holds column l + 1.
+            auto code = _mm512_and_si512(_mm512_srlv_epi32(top, shifts), seven);
+            code = _mm512_or_si512(code, _mm512_slli_epi32(_mm512_and_si512(_mm512_srlv_epi32(middle, shifts), seven), 3));
+            code = _mm512_or_si512(code, _mm512_slli_epi32(_mm512_and_si512(_mm512_srlv_epi32(bottom, shifts), seven), 6));
+
+            const auto words = _mm512_i32gather_epi32(_mm512_srli_epi32(code, 2), table, 4);
+            const auto values = _mm512_and_si512(_mm512_srlv_epi32(words, _mm512_slli_epi32(_mm512_and_si512(code, three), 3)), byteMask);
+
+            const int set = _mm512_cmpeq_epi32_mask(values, one);
+            const int cleared = _mm512_cmpeq_epi32_mask(values, zero);
+
+            CommitRow(barcode, j, set << 1, cleared << 1);
+        }
+    }
+#else
+    void StepKernels::Step3x3AVX2(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows)
+    {
+        Step3x3Scalar(oldBarcode, rules, barcode, rows);
+    }
+
+
+    void StepKernels::Step3x3AVX512(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows)
+    {
+        Step3x3Scalar(oldBarcode, rules, barcode, rows);
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Helpers.h"
+#include "RuleTable.h"
+
+namespace ABME
+{
+    enum InstructionSet
+    {
+        InstructionSetScalar,
+        InstructionSetAVX2,
+        InstructionSetAVX512,
+    };
+
+
+    /// Kernels applying a compiled 3x3 rule table to the 14x14 inner cells of a
+    /// barcode. The widest kernel the CPU supports is selected at startup; CPUs
+    /// without AVX2 use the scalar kernel.
+    class StepKernels
+    {
+    public:
+        using KernelFunction = void (*)(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows);
+
+        static InstructionSet Detect();
+        static const char* GetName(InstructionSet instructionSet);
+        static InstructionSet GetSelected();
+        static InstructionSet Select(InstructionSet instructionSet);
+
+        /// Reads neighbourhoods from oldBarcode and writes every cell with a gene into barcode.
+        /// Only the rows selected in the rows mask (bit j for row j) are evaluated.
+        static inline void Step3x3(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows = 0xFFFF)
+        {
+            Kernel(oldBarcode, rules, barcode, rows);
+        }
+
+    protected:
+        static void Step3x3Scalar(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows);
+        static void Step3x3AVX2(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows);
+        static void Step3x3AVX512(const BarcodeBits& oldBarcode, const RuleTable& rules, BarcodeBits& barcode, int rows);
+
+        static InstructionSet Selected;
+        static KernelFunction Kernel;
+    };
+}
\ No newline at end of file
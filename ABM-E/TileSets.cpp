@@ -0,0 +1,99 @@
+#include "TileSets.h"
+
+#include <sstream>
+
+namespace ABME
+{
+    /// Returns each region's active tiles and the flows that led to them.
+    std::string TileSets::GetStatistics() const
+    {
+        std::stringstream statistics;
+        for (auto i = 0; i < Regions.size(); ++i)
+        {
+            const auto& ledger = Ledgers[i];
+            statistics << (i > 0 ? "; " : "") << "region " << i << ": " << Count(i, true) << " active (" << ledger.Initial
+                << " initially, generation +" << ledger.Added[TileSourceGeneration] << "/-" << ledger.Removed[TileSourceGeneration]
+                << ", individuals +" << ledger.Added[TileSourceIndividuals] << "/-" << ledger.Removed[TileSourceIndividuals];
+            if (ledger.Added[TileSourceNeighbours] > 0 || ledger.Removed[TileSourceNeighbours] > 0) statistics << ", neighbours +" << ledger.Added[TileSourceNeighbours] << "/-" << ledger.Removed[TileSourceNeighbours];
+            statistics << ")";
+        }
+
+        return statistics.str();
+    }
+
+
+    /// Rebuilds the sets from a map. Keeps a reference to the regions.
+    void TileSets::Reset(const PackedMap& map, const RegionMap& regions, int numRegions)
+    {
+        Width = map.GetWidth();
+        ChunksPerRow = (map.GetWidth() + ChunkSize - 1) / ChunkSize;
+        NumActive = 0;
+        Raster = &regions;
+        Regions.assign(numRegions, {});
+        Ledgers.assign(numRegions, {});
+        Chunks.clear();
+        Chunks.resize(size_t(ChunksPerRow) * ((map.GetHeight() + ChunkSize - 1) / ChunkSize));
+
+        // Tiles are filed in row order, as the region tiles of each map row come up.
+        for (auto y = 0; y < map.GetHeight(); ++y)
+        {
+            for (auto cx = 0; cx < ChunksPerRow; ++cx)
+            {
+                const auto area = cv::Rect(cx * ChunkSize, y, ChunkSize, 1) & cv::Rect(0, 0, map.GetWidth(), map.GetHeight());
+                if (regions.CountAllowed(area) == 0) continue;
+
+                auto& chunk = Chunks[size_t(y / ChunkSize) * ChunksPerRow + cx];
+                if (chunk == nullptr)
+                {
+                    chunk.reset(new Chunk());
+                    chunk->Active.fill(0);
+                }
+
+                for (auto x = area.x; x < area.x + area.width; ++x)
+                {
+                    const auto index = regions.IndexAt(x, y);
+                    if (index < 0) continue;
+
+                    const auto active = map.Get(x, y);
+                    auto& set = Regions[index][active];
+                    chunk->Positions[(y & ChunkMask) * ChunkSize + (x & ChunkMask)] = int(set.size());
+                    if (active) chunk->Active[y & ChunkMask] |= std::uint64_t(1) << (x & ChunkMask);
+                    set.push_back(y * Width + x);
+                    if (active) ++NumActive;
+                }
+            }
+        }
+
+        for (auto i = 0; i < numRegions; ++i) Ledgers[i].Initial = Count(i, true);
+    }
+
+
+    /// Moves a tile to the active or inactive set of its region, entering
+    /// the move in the region's ledger.
+    void TileSets::Set(int x, int y, bool active, TileSource source)
+    {
+        const auto index = Raster->IndexAt(x, y);
+        if (index < 0) return;
+
+        auto& chunk = *Chunks[size_t(y / ChunkSize) * ChunksPerRow + x / ChunkSize];
+        auto& states = chunk.Active[y & ChunkMask];
+        const auto bit = std::uint64_t(1) << (x & ChunkMask);
+        if (bool(states & bit) == active) return;
+
+        // Fill the tile's place with the last of its set.
+        const auto tile = y * Width + x;
+        auto& position = chunk.Positions[(y & ChunkMask) * ChunkSize + (x & ChunkMask)];
+        auto& from = Regions[index][!active];
+        const auto last = from.back();
+        from[position] = last;
+        GetPosition(last) = position;
+        from.pop_back();
+
+        auto& to = Regions[index][active];
+        position = int(to.size());
+        to.push_back(tile);
+        states ^= bit;
+        NumActive += active ? 1 : -1;
+        ++(active ? Ledgers[index].Added : Ledgers[index].Removed)[source];
+    }
+}
\ No newline at end of file
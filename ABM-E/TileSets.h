@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include "PackedMap.h"
+#include "RegionMap.h"
+
+namespace ABME
+{
+    /// What activated or deactivated a tile.
+    enum TileSource
+    {
+        TileSourceGeneration, // Initial tiles and crises.
+        TileSourceIndividuals, // Individuals acting on the world.
+        TileSourceNeighbours, // Other workers' individuals, across a domain border.
+        NumTileSources,
+    };
+
+
+    /// The flows of active tiles in and out of a region, by source, since its
+    /// sets were built. The region's active count always equals the balance.
+    struct TileLedger
+    {
+        int Initial = 0;
+        std::array<int, NumTileSources> Added{};
+        std::array<int, NumTileSources> Removed{};
+
+        inline int GetBalance() const
+        {
+            auto balance = Initial;
+            for (auto source = 0; source < NumTileSources; ++source) balance += Added[source] - Removed[source];
+            return balance;
+        }
+    };
+
+
+    /// The tiles of each region, split into an active and an inactive set.
+    /// Each set is a dense array of tile indices (y * width + x), and every
+    /// tile knows its position in its set, so a tile moves between sets in
+    /// constant time (swapped with the last) and a random member of a set is
+    /// a single draw. Tiles outside every region are not tracked: positions
+    /// and states are kept in 64x64 chunks, stored only for chunks with
+    /// region tiles, and the region of a tile is read from the region map.
+    class TileSets
+    {
+    public:
+        std::string GetStatistics() const;
+        void Reset(const PackedMap& map, const RegionMap& regions, int numRegions);
+        void Set(int x, int y, bool active, TileSource source);
+
+        /// Returns the number of active tiles in all regions.
+        inline int CountActive() const
+        {
+            return NumActive;
+        }
+
+
+        /// Returns the number of active (or inactive) tiles in a region.
+        inline int Count(int regionIndex, bool active) const
+        {
+            return int(Regions[regionIndex][active].size());
+        }
+
+
+        inline const TileLedger& GetLedger(int regionIndex) const
+        {
+            return Ledgers[regionIndex];
+        }
+
+
+        /// Returns the index of a random active (or inactive) tile of a
+        /// region, which must have one.
+        template <typename TRandom>
+        inline int Pick(int regionIndex, bool active, TRandom& rng) const
+        {
+            auto& tiles = Regions[regionIndex][active];
+            std::uniform_int_distribution<size_t> dist(0, tiles.size() - 1);
+            return tiles[dist(rng)];
+        }
+
+        static constexpr int ChunkSize = 64;
+
+    protected:
+        struct Chunk
+        {
+            std::array<int, ChunkSize * ChunkSize> Positions; // Per tile, its position in its set.
+            std::array<std::uint64_t, ChunkSize> Active; // Per tile, a bit.
+        };
+
+        static constexpr int ChunkMask = ChunkSize - 1;
+
+        int Width = 0;
+        int ChunksPerRow = 0;
+        int NumActive = 0;
+        const RegionMap* Raster = nullptr;
+        std::vector<std::array<std::vector<int>, 2>> Regions; // Inactive, then active tiles.
+        std::vector<TileLedger> Ledgers; // Per region.
+        std::vector<std::unique_ptr<Chunk>> Chunks; // Null where no tile is in a region.
+
+        inline int& GetPosition(int tile)
+        {
+            const auto x = tile % Width;
+            const auto y = tile / Width;
+            return Chunks[size_t(y / ChunkSize) * ChunksPerRow + x / ChunkSize]->Positions[(y & ChunkMask) * ChunkSize + (x & ChunkMask)];
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "Tournament.h"
+
+#include <iterator>
+#include <stdexcept>
+#include "Barcode.h"
+#include "GlobalSettings.h"
+#include "Interactor.h"
+#include "Message.h"
+
+namespace ABME
+{
+    static const char Magic[4] = { 'A', 'B', 'M', 'T' };
+
+    // Worlds in the default set-up hold roughly 13% tiles; seeds sweep sensed
+    // densities up to about twice that.
+    static const double MaxTileDensity = 0.25;
+
+
+    /// Returns a uniform number in [0, 1) from the top 53 bits of a draw.
+    static inline double Uniform(RandomStream& rng)
+    {
+        return double(rng() >> 11) / 9007199254740992.0;
+    }
+
+
+    /// Draws the tile patch of each seed from the base seed, and the barcode
+    /// each genome starts from after sensing it.
+    Tournament::Tournament(const std::vector<GeneticCode<ushort>>& genomes, int numSeeds, std::uint64_t baseSeed) : Genomes(genomes), NumSeeds(numSeeds), BaseSeed(baseSeed)
+    {
+        if (numSeeds < 1) throw std::runtime_error("A tournament needs at least one seed.");
+
+        for (auto& genome : Genomes) genome.BehaviourGenes.Compile(true);
+
+        StartBarcodes.resize(size_t(numSeeds) * Genomes.size());
+        for (auto seed = 0; seed < numSeeds; ++seed)
+        {
+            RandomStream rng(Helpers::HashCombine(baseSeed, std::uint64_t(seed)));
+
+            // Individuals are born with an empty barcode, so the first one they
+            // interact with is the sensed patch after one step.
+            BarcodeBits patch = {};
+            const auto density = MaxTileDensity * (1.0 - Uniform(rng));
+            for (auto i = 0; i < GlobalSettings::BarcodeSize * GlobalSettings::BarcodeSize; ++i)
+            {
+                Helpers::AssignBit(patch, i, Uniform(rng) < density);
+            }
+
+            for (size_t genome = 0; genome < Genomes.size(); ++genome)
+            {
+                auto& behaviourGenes = Genomes[genome].BehaviourGenes;
+                StartBarcodes[seed * Genomes.size() + genome] = Barcode::Step(patch, behaviourGenes.Rules, behaviourGenes.HasLargePatterns);
+            }
+        }
+    }
+
+
+    TournamentOutcome Tournament::Get(int seed, int first, int second) const
+    {
+        const auto numGenomes = Genomes.size();
+        return TournamentOutcome(Outcomes[(size_t(seed) * numGenomes + first) * numGenomes + second]);
+    }
+
+
+    /// Plays the whole grid. Each task is one first genome against all the
+    /// others from one seed, so its rules stay in cache.
+    void Tournament::Run()
+    {
+        const auto numGenomes = int(Genomes.size());
+        const auto numRows = NumSeeds * numGenomes;
+        Outcomes.assign(size_t(numRows) * numGenomes, TournamentBothSurvive);
+
+#pragma omp parallel for schedule(dynamic)
+        for (int row = 0; row < numRows; ++row)
+        {
+            const auto seed = row / numGenomes;
+            auto& first = Genomes[row % numGenomes];
+            auto* outcomes = &Outcomes[size_t(row) * numGenomes];
+            const auto* barcodes = &StartBarcodes[size_t(seed) * numGenomes];
+
+            for (auto column = 0; column < numGenomes; ++column)
+            {
+                auto& second = Genomes[column];
+                const auto outcome = Interactor::Play(barcodes[row % numGenomes], first.BehaviourGenes.Rules, first.BehaviourGenes.HasLargePatterns, barcodes[column], second.BehaviourGenes.Rules, second.BehaviourGenes.HasLargePatterns);
+
+                if (outcome.FirstDies || outcome.SecondDies) outcomes[column] = uchar((outcome.FirstDies ? TournamentFirstDies : 0) | (outcome.SecondDies ? TournamentSecondDies : 0));
+                else if (!GlobalSettings::ForceEqualChromosomeReproductions || first.Length() == second.Length()) outcomes[column] = TournamentReproduce;
+                else outcomes[column] = TournamentBothSurvive;
+            }
+        }
+    }
+
+
+    /// Writes the outcome matrix: "ABMT", the number of genomes and of seeds
+    /// (32-bit), the base seed (64-bit), then one TournamentOutcome byte per
+    /// game, indexed [seed][first][second].
+    void Tournament::Write(std::ostream& out) const
+    {
+        MessageWriter header;
+        for (auto c : Magic) header.Write(c);
+        header.Write(std::int32_t(Genomes.size()));
+        header.Write(std::int32_t(NumSeeds));
+        header.Write(BaseSeed);
+
+        out.write(reinterpret_cast<const char*>(header.Bytes.data()), header.Bytes.size());
+        out.write(reinterpret_cast<const char*>(Outcomes.data()), Outcomes.size());
+        if (!out) throw std::runtime_error("Couldn't write the tournament outcomes.");
+    }
+
+
+    /// Reads genomes written by WriteGenomes.
+    std::vector<GeneticCode<ushort>> Tournament::ReadGenomes(std::istream& in)
+    {
+        if (!in) throw std::runtime_error("Couldn't read the genomes.");
+        const std::vector<uchar> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::vector<GeneticCode<ushort>> genomes;
+        MessageReader reader(bytes);
+        while (!reader.AtEnd())
+        {
+            genomes.emplace_back();
+            genomes.back().Read(reader);
+        }
+
+        return genomes;
+    }
+
+
+    /// Writes genomes one after the other, as GeneticCode::Write does.
+    void Tournament::WriteGenomes(std::ostream& out, const std::vector<GeneticCode<ushort>>& genomes)
+    {
+        MessageWriter message;
+        for (auto& genome : genomes) genome.Write(message);
+
+        out.write(reinterpret_cast<const char*>(message.Bytes.data()), message.Bytes.size());
+        if (!out) throw std::runtime_error("Couldn't write the genomes.");
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "GeneticCode.h"
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// How one game of a tournament ended. Survivors reproduce if their genomes
+    /// are compatible, assuming both are of age and have vitality to spare.
+    enum TournamentOutcome : uchar
+    {
+        TournamentBothSurvive, // Without offspring (lengths differ while ForceEqualChromosomeReproductions is set).
+        TournamentFirstDies,
+        TournamentSecondDies,
+        TournamentBothDie,
+        TournamentReproduce,
+    };
+
+
+    /// Plays every ordered pair of a set of genomes against each other through
+    /// Interactor::Play, once from each of a number of seeds. A seed is a random
+    /// patch of world tiles; as colocated individuals in the world do, both
+    /// players sense the same patch and step it once with their own genes
+    /// before the game starts. The patches are drawn from a base seed, so a
+    /// tournament is reproducible from its genomes, seed count and base seed.
+    /// Games are independent, so the grid is spread over the OpenMP threads.
+    class Tournament
+    {
+    public:
+        Tournament(const std::vector<GeneticCode<ushort>>& genomes, int numSeeds, std::uint64_t baseSeed = DefaultBaseSeed);
+
+        TournamentOutcome Get(int seed, int first, int second) const;
+        void Run();
+        void Write(std::ostream& out) const;
+
+        static std::vector<GeneticCode<ushort>> ReadGenomes(std::istream& in);
+        static void WriteGenomes(std::ostream& out, const std::vector<GeneticCode<ushort>>& genomes);
+
+        static constexpr std::uint64_t DefaultBaseSeed = 1;
+
+    protected:
+        std::vector<GeneticCode<ushort>> Genomes; // Behaviour genes compiled.
+        int NumSeeds;
+        std::uint64_t BaseSeed;
+        std::vector<BarcodeBits> StartBarcodes; // Indexed [seed][genome].
+        std::vector<uchar> Outcomes; // Indexed [seed][first][second].
+    };
+}
@@ -0,0 +1,13 @@
+#include "TransitionCache.h"
+
+#include "GlobalSettings.h"
+
+namespace ABME
+{
+    /// Returns the shared cache, created on first use (which may be on any thread).
+    TransitionCache& TransitionCache::Instance()
+    {
+        static TransitionCache instance(GlobalSettings::TransitionCacheSize);
+        return instance;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Helpers.h"
+#include "SetAssociativeCache.h"
+
+namespace ABME
+{
+    /// A barcode step's key: the genome's fingerprint and checksum, and the barcode.
+    struct TransitionKey
+    {
+        std::uint64_t Genome = 0;
+        std::uint64_t Checksum = 0;
+        BarcodeBits State = {};
+
+        inline bool operator==(const TransitionKey& other) const
+        {
+            return Genome == other.Genome && Checksum == other.Checksum && State == other.State;
+        }
+
+
+        inline std::uint64_t Hash() const
+        {
+            return Helpers::Hash(State, Genome);
+        }
+    };
+
+
+    /// Memoises barcode steps: maps (genome fingerprint, barcode) to the next
+    /// barcode. Entries also hold the genome's checksum, so a hit needs both
+    /// genome hashes to match.
+    class TransitionCache : public SetAssociativeCache<TransitionKey, BarcodeBits>
+    {
+    public:
+        TransitionCache(int numEntries) : SetAssociativeCache(numEntries)
+        {
+        }
+
+
+        inline bool Find(std::uint64_t genome, std::uint64_t checksum, const BarcodeBits& state, BarcodeBits& next)
+        {
+            return SetAssociativeCache::Find({ genome, checksum, state }, next);
+        }
+
+
+        inline void Insert(std::uint64_t genome, std::uint64_t checksum, const BarcodeBits& state, const BarcodeBits& next)
+        {
+            SetAssociativeCache::Insert({ genome, checksum, state }, next);
+        }
+
+        static TransitionCache& Instance();
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include "Helpers.h"
+
+namespace ABME
+{
+    /// Carries messages between the worker processes of a decomposed world
+    /// (ranked 0 to GetSize() - 1). Messages between two workers arrive in the
+    /// order they were sent. Implementations may block on Send until the
+    /// peer receives.
+    class Transport
+    {
+    public:
+        virtual ~Transport() = default;
+
+        virtual int GetRank() const = 0;
+        virtual int GetSize() const = 0;
+        virtual std::vector<uchar> Receive(int peer) = 0;
+        virtual void Send(int peer, const std::vector<uchar>& message) = 0;
+
+        /// Sends a message to a peer and returns the one it sends back. The
+        /// lower rank sends first, so two workers exchanging with each other
+        /// never both wait to send.
+        inline std::vector<uchar> Exchange(int peer, const std::vector<uchar>& message)
+        {
+            if (GetRank() < peer)
+            {
+                Send(peer, message);
+                return Receive(peer);
+            }
+
+            auto reply = Receive(peer);
+            Send(peer, message);
+            return reply;
+        }
+    };
+}
\ No newline at end of file
@@ -1,20 +1,53 @@
 #include <ctime>
+#include <fstream>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include "Benchmarks.h"
+#include "Domain.h"
 #include "Environment.h"
 #include "GlobalSettings.h"
 #include "Helpers.h"
 #include "Individual.h"
 #include "Logger.h"
+#include "SocketTransport.h"
+#include "StepKernels.h"
+#include "Tournament.h"
 
 using namespace ABME;
 using namespace cv;
 
 int main(int argc, char** argv)
 {
+    // Run the microbenchmarks instead of the simulation if requested.
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        Benchmarks::Run(std::cout);
+        return 0;
+    }
+
+    // Play a tournament between saved genomes instead if requested (--tournament <genomes> <outcomes> [seeds] [threads] [base seed]).
+    if (argc > 3 && std::string(argv[1]) == "--tournament")
+    {
+        GlobalSettings::Initialise(argc > 5 ? std::atoi(argv[5]) : 6);
+
+        std::ifstream in(argv[2], std::ios::binary);
+        Tournament tournament(Tournament::ReadGenomes(in), argc > 4 ? std::atoi(argv[4]) : 8, argc > 6 ? std::strtoull(argv[6], nullptr, 10) : Tournament::DefaultBaseSeed);
+
+        clock_t begin = clock();
+        tournament.Run();
+        std::cout << "Played the tournament in " << double(clock() - begin) / CLOCKS_PER_SEC << " s (CPU).\n";
+
+        std::ofstream out(argv[3], std::ios::binary);
+        tournament.Write(out);
+        return 0;
+    }
+
+    // Split the world between worker processes if requested (--domains <workers> [steps]).
+    const bool useDomains = argc > 2 && std::string(argv[1]) == "--domains";
+
     // Read the number of threads if passed.
-    int numThreads = argc > 1 ? std::atoi(argv[1]) : 6;
+    int numThreads = useDomains ? 1 : argc > 1 ? std::atoi(argv[1]) : 6;
 
     // Initialise global parameters.
     GlobalSettings::Initialise(numThreads);
@@ -24,6 +57,7 @@ int main(int argc, char** argv)
     GlobalSettings::TileDepositsEqualDifference = false;
     GlobalSettings::MutationRatesEvolve = true;
     GlobalSettings::UseSingleStructuralMutationRate = false;
+    GlobalSettings::UseTransitionCache = true;
 
     // Create a logger.
     auto& logger = Logger::Instance();
@@ -39,18 +73,44 @@ int main(int argc, char** argv)
     //environment.AddRegion(cv::Rect(136, 0, 120, 128), 0.01f);
     //environment.AddRegion(cv::Rect(120, 56, 16, 16), 0.00f);
 
-    Environment environment(128, 128);
-    environment.AddRegion(cv::Rect(0, 0, 56, 128), 0.05f);
-    environment.AddRegion(cv::Rect(72, 0, 56, 128), 0.03f);
-    environment.AddRegion(cv::Rect(56, 56, 16, 16), 0.00f);
+    // The world, set up the same way in one environment or split between workers.
+    const int worldWidth = 128;
+    const int worldHeight = 128;
+    auto addRegions = [](auto& world)
+    {
+        world.AddRegion(cv::Rect(0, 0, 56, 128), 0.05f);
+        world.AddRegion(cv::Rect(72, 0, 56, 128), 0.03f);
+        world.AddRegion(cv::Rect(56, 56, 16, 16), 0.00f);
+    };
 
     //Environment environment(128, 128);
     ////environment.AddRegion(cv::Rect(0, 0, 120, 128), 0.08f);
     //environment.AddRegion(cv::Rect(0, 0, 128, 128), 0.01f);
 
+    // Every worker sets up its own strip of the world. The workers are forked
+    // before any OpenMP region, and run single threaded.
+    if (useDomains)
+    {
+        const auto numWorkers = std::atoi(argv[2]);
+        const auto numSteps = argc > 3 ? std::atoi(argv[3]) : 1000;
+        const auto failures = SocketTransport::Launch(numWorkers, [&](Transport& transport)
+        {
+            Domain domain(worldWidth, worldHeight, transport);
+            addRegions(domain);
+            domain.Initialise({ { 4, 2000 }, { 5, 2000 } }, false, true);
+            for (auto step = 0; step < numSteps; ++step) domain.Update();
+            domain.LogTotals();
+        });
+
+        std::cout << "Finished [" << numWorkers << " workers, " << failures << " failed]\n";
+        return failures > 0 ? 1 : 0;
+    }
+
+    Environment environment(worldWidth, worldHeight);
+    addRegions(environment);
     environment.Initialise({ { 4, 2000 }, { 5, 2000 } }, false, true);
 
-    std::cout << "Starting [" << numThreads << " threads]\n";
+    std::cout << "Starting [" << numThreads << " threads, " << StepKernels::GetName(StepKernels::GetSelected()) << " barcode kernel]\n";
     
     clock_t begin = clock();
 
@@ -102,6 +162,14 @@ int main(int argc, char** argv)
         case 't':
             environment.ToggleDrawMode();
             break;
+        case 'g':
+        {
+            std::ofstream out("genomes.bin", std::ios::binary);
+            const auto genomes = environment.GetDominantGenomes(256);
+            Tournament::WriteGenomes(out, genomes);
+            std::cout << "Saved the " << genomes.size() << " most common genomes to genomes.bin" << std::endl;
+            break;
+        }
         case '+':
             intruderGeneticLength++;
             std::cout << "Genetic length of intruder population set to " << intruderGeneticLength << std::endl;